@@ -0,0 +1,33 @@
+#ifndef NANORESOURCE_BENCH_H
+#define NANORESOURCE_BENCH_H
+
+#include <nanoresource/nanoresource.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS 1000000
+#endif
+
+/**
+ * Writes a benchmark result as a single line of JSON to stdout so results
+ * can be collected and compared across commits, ie:
+ *   {"bench":"queue.push_shift","depth":64,"ops":1000000,"ns":...}
+ */
+static void
+bench_report(const char *name, const char *params, uint64_t ops, uint64_t ns) {
+  double seconds = (double) ns / 1e9;
+  printf(
+    "{\"bench\":\"%s\",%s%s\"ops\":%llu,\"ns\":%llu,"
+    "\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f}\n",
+    name,
+    0 != params ? params : "",
+    0 != params ? "," : "",
+    (unsigned long long) ops,
+    (unsigned long long) ns,
+    0 != ops ? (double) ns / (double) ops : 0,
+    seconds > 0 ? (double) ops / seconds : 0);
+  fflush(stdout);
+}
+
+#endif
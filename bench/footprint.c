@@ -0,0 +1,92 @@
+#include "bench.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifndef FOOTPRINT_RESOURCES
+#define FOOTPRINT_RESOURCES 1000000
+#endif
+
+static void
+park(struct nanoresource_request_s *request) {
+  (void) request;
+}
+
+static uint64_t
+rss() {
+  unsigned long size = 0;
+  unsigned long resident = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+
+  if (0 == statm) {
+    return 0;
+  }
+
+  if (2 != fscanf(statm, "%lu %lu", &size, &resident)) {
+    resident = 0;
+  }
+
+  fclose(statm);
+  return (uint64_t) resident * (uint64_t) sysconf(_SC_PAGESIZE);
+}
+
+int
+main(int argc, char **argv) {
+  unsigned long count = argc > 1 ? strtoul(argv[1], 0, 10) : FOOTPRINT_RESOURCES;
+  struct nanoresource_s **resources = calloc(count, sizeof(*resources));
+  uint64_t baseline = 0;
+  uint64_t idle = 0;
+  uint64_t inflight = 0;
+
+  if (0 == resources || 0 == count) {
+    return 1;
+  }
+
+  baseline = rss();
+
+  // idle (opened) resources
+  for (unsigned long i = 0; i < count; ++i) {
+    resources[i] = nanoresource_new((struct nanoresource_options_s) { 0 });
+
+    if (0 == resources[i]) {
+      fprintf(stderr, "footprint: out of memory after %lu resources\n", i);
+      return 1;
+    }
+
+    nanoresource_open(resources[i], 0);
+  }
+
+  idle = rss();
+
+  // one in-flight (running, never completed) user request per resource
+  for (unsigned long i = 0; i < count; ++i) {
+    nanoresource_submit(resources[i], nanoresource_request_new(
+      (struct nanoresource_request_options_s) {
+        .type = NANORESOURCE_REQUEST_USER,
+        .resource = resources[i],
+        .user = park
+      }));
+  }
+
+  inflight = rss();
+
+  printf(
+    "{\"bench\":\"footprint\",\"queue\":%u,\"resources\":%lu,"
+    "\"sizeof_resource\":%zu,\"sizeof_request\":%zu,"
+    "\"rss_bytes\":%llu,\"bytes_per_resource\":%.1f,"
+    "\"bytes_per_request\":%.1f}\n",
+    NANORESOURCE_MAX_REQUEST_QUEUE,
+    count,
+    sizeof(struct nanoresource_s),
+    sizeof(struct nanoresource_request_s),
+    (unsigned long long) inflight,
+    (double) (idle - baseline) / (double) count,
+    (double) (inflight - idle) / (double) count);
+
+  for (unsigned long i = 0; i < count; ++i) {
+    nanoresource_request_free(nanoresource_queue_shift(resources[i]));
+    nanoresource_free(resources[i]);
+  }
+
+  free(resources);
+  return 0;
+}
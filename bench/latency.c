@@ -0,0 +1,110 @@
+#include "bench.h"
+#include <stdlib.h>
+
+#define DEPTH 64
+#define URGENT_EVERY 16
+
+static struct nanoresource_request_s *parked = 0;
+static struct nanoresource_histogram_s urgent = { 0 };
+
+static void
+complete(struct nanoresource_request_s *request) {
+  request->callback(request, 0);
+}
+
+static void
+park(struct nanoresource_request_s *request) {
+  parked = request;
+}
+
+// latency from submit to completion of urgent requests
+static int
+record(struct nanoresource_request_s *request, unsigned int err) {
+  if (request->priority > 0) {
+    uint64_t submitted = (uint64_t) (uintptr_t) request->data;
+    nanoresource_histogram_record(&urgent,
+      nanoresource_clock_now() - submitted);
+  }
+
+  return 0;
+}
+
+static void
+submit(struct nanoresource_s *resource, uint64_t i) {
+  uint64_t now = nanoresource_clock_now();
+  int is_urgent = 0 == i % URGENT_EVERY;
+
+  nanoresource_submit(resource, nanoresource_request_new(
+    (struct nanoresource_request_options_s) {
+      .type = NANORESOURCE_REQUEST_USER,
+      .resource = resource,
+      .user = park,
+      .after = record,
+      .data = (void *) (uintptr_t) now,
+      .priority = is_urgent ? 1 : 0,
+      .deadline = now + (is_urgent ? 1000 : 1000000),
+    }));
+}
+
+/**
+ * Keeps `DEPTH` requests queued on a serial resource, completing the
+ * running one each round, where every `URGENT_EVERY`th request is urgent
+ * (higher priority, earlier deadline) and the rest are bulk work.
+ */
+static void
+bench_mixed(const char *name, enum nanoresource_queue_discipline discipline) {
+  const uint64_t ops = BENCH_ITERATIONS;
+  char params[96] = { 0 };
+  uint64_t submitted = 0;
+  uint64_t done = 0;
+
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) {
+      .open = complete,
+      .close = complete,
+      .destroy = complete,
+      .discipline = discipline,
+    });
+
+  nanoresource_open(resource, 0);
+  nanoresource_histogram_reset(&urgent);
+
+  uint64_t start = nanoresource_clock_now();
+
+  while (done < ops) {
+    while (resource->queued < DEPTH) {
+      submit(resource, submitted++);
+    }
+
+    struct nanoresource_request_s *request = parked;
+    parked = 0;
+    request->callback(request, 0);
+    done++;
+  }
+
+  uint64_t ns = nanoresource_clock_now() - start;
+
+  while (0 != parked) {
+    struct nanoresource_request_s *request = parked;
+    parked = 0;
+    request->callback(request, 0);
+  }
+
+  nanoresource_destroy(resource, 0);
+
+  snprintf(params, sizeof(params),
+    "\"discipline\":\"%s\",\"urgent_p50_ns\":%llu,\"urgent_p99_ns\":%llu",
+    name,
+    (unsigned long long) nanoresource_histogram_percentile(&urgent, 50),
+    (unsigned long long) nanoresource_histogram_percentile(&urgent, 99));
+
+  bench_report("user.mixed_latency", params, ops, ns);
+}
+
+int
+main(void) {
+  bench_mixed("fifo", NANORESOURCE_QUEUE_FIFO);
+  bench_mixed("priority", NANORESOURCE_QUEUE_PRIORITY);
+  bench_mixed("deadline", NANORESOURCE_QUEUE_DEADLINE);
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include "bench.h"
+#include <nanoresource/specialize.h>
+
+static unsigned long long completed = 0;
+
+static void
+complete(struct nanoresource_request_s *request) {
+  request->callback(request, 0);
+}
+
+static void
+work(struct nanoresource_request_s *request) {
+  completed++;
+  request->callback(request, 0);
+}
+
+NANORESOURCE_SPECIALIZE(direct, complete, complete, complete, work)
+
+static void
+bench_user(const char *name, int specialized, int sync) {
+  const uint64_t ops = BENCH_ITERATIONS;
+  struct nanoresource_options_s options = { 0 };
+  struct nanoresource_s resource = { 0 };
+
+  options.sync = sync;
+
+  if (1 == specialized) {
+    direct_init(&resource, options);
+    direct_open(&resource, 0);
+  } else {
+    options.open = complete;
+    options.close = complete;
+    options.destroy = complete;
+    nanoresource_init(&resource, options);
+    nanoresource_open(&resource, 0);
+  }
+
+  struct nanoresource_request_options_s request_options = { 0 };
+  struct nanoresource_request_s request;
+
+  request_options.type = NANORESOURCE_REQUEST_USER;
+  request_options.resource = &resource;
+  request_options.user = work;
+
+  uint64_t start = nanoresource_clock_now();
+
+  // one request is reused, `nanoresource_request_init()` resets it
+  for (uint64_t i = 0; i < ops; ++i) {
+    nanoresource_request_init(&request, request_options);
+
+    if (1 == specialized) {
+      direct_submit(&resource, &request);
+    } else {
+      nanoresource_submit(&resource, &request);
+    }
+  }
+
+  bench_report(name, 0, ops, nanoresource_clock_now() - start);
+}
+
+static void
+bench_lifecycle(const char *name, int specialized) {
+  const uint64_t ops = BENCH_ITERATIONS / 4;
+  struct nanoresource_options_s options = { 0 };
+  uint64_t start = nanoresource_clock_now();
+
+  for (uint64_t i = 0; i < ops; ++i) {
+    struct nanoresource_s resource = { 0 };
+
+    if (1 == specialized) {
+      direct_init(&resource, options);
+      direct_open(&resource, 0);
+      direct_close(&resource, 0);
+    } else {
+      options.open = complete;
+      options.close = complete;
+      options.destroy = complete;
+      nanoresource_init(&resource, options);
+      nanoresource_open(&resource, 0);
+      nanoresource_close(&resource, 0);
+    }
+  }
+
+  bench_report(name, 0, ops, nanoresource_clock_now() - start);
+}
+
+int
+main(void) {
+  bench_user("specialize.user.pointer", 0, 0);
+  bench_user("specialize.user.direct", 1, 0);
+  bench_user("specialize.user.pointer.sync", 0, 1);
+  bench_user("specialize.user.direct.sync", 1, 1);
+  bench_lifecycle("specialize.open_close.pointer", 0);
+  bench_lifecycle("specialize.open_close.direct", 1);
+  return 0 == completed;
+}
@@ -0,0 +1,263 @@
+#include "bench.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_DEPTH 256
+#define MAX_THREADS 8
+
+static struct nanoresource_request_s *parked[MAX_DEPTH + 1] = { 0 };
+static unsigned int nparked = 0;
+
+static void
+complete(struct nanoresource_request_s *request) {
+  request->callback(request, 0);
+}
+
+static void
+park(struct nanoresource_request_s *request) {
+  parked[nparked++] = request;
+}
+
+static struct nanoresource_s *
+opened(nanoresource_request_work_callback_t *work) {
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) {
+      .open = work,
+      .close = work,
+      .destroy = work,
+    });
+
+  nanoresource_open(resource, 0);
+  return resource;
+}
+
+static void
+bench_lifecycle(void) {
+  const uint64_t ops = BENCH_ITERATIONS / 4;
+  uint64_t start = nanoresource_clock_now();
+
+  for (uint64_t i = 0; i < ops; ++i) {
+    struct nanoresource_s *resource = opened(complete);
+    nanoresource_close(resource, 0);
+    nanoresource_destroy(resource, 0);
+  }
+
+  bench_report("lifecycle.open_close_destroy", 0, ops,
+    nanoresource_clock_now() - start);
+}
+
+static void
+bench_user(unsigned int depth) {
+  const uint64_t ops = BENCH_ITERATIONS;
+  struct nanoresource_s *resource = opened(complete);
+  char params[32] = { 0 };
+  uint64_t done = 0;
+  uint64_t start = nanoresource_clock_now();
+
+  // keep `depth` requests queued, completing the running one each round
+  while (done < ops) {
+    while (resource->queued < depth) {
+      nanoresource_submit(resource, nanoresource_request_new(
+        (struct nanoresource_request_options_s) {
+          .type = NANORESOURCE_REQUEST_USER,
+          .resource = resource,
+          .user = park,
+        }));
+    }
+
+    struct nanoresource_request_s *request = parked[--nparked];
+    request->callback(request, 0);
+    (void) done++;
+  }
+
+  uint64_t ns = nanoresource_clock_now() - start;
+
+  while (nparked > 0) {
+    struct nanoresource_request_s *request = parked[--nparked];
+    request->callback(request, 0);
+  }
+
+  while (resource->queued > 0) {
+    nanoresource_request_free(nanoresource_queue_shift(resource));
+  }
+
+  nanoresource_destroy(resource, 0);
+  snprintf(params, sizeof(params), "\"depth\":%u", depth);
+  bench_report("user.submit_complete", params, ops, ns);
+}
+
+static void
+bench_queue(unsigned int depth) {
+  const uint64_t rounds = BENCH_ITERATIONS / depth;
+  struct nanoresource_request_s requests[MAX_DEPTH];
+  struct nanoresource_s resource;
+  char params[32] = { 0 };
+
+  nanoresource_init(&resource, (struct nanoresource_options_s) { 0 });
+
+  for (unsigned int i = 0; i < depth; ++i) {
+    nanoresource_request_init(&requests[i],
+      (struct nanoresource_request_options_s) {
+        .type = NANORESOURCE_REQUEST_USER,
+        .resource = &resource
+      });
+  }
+
+  uint64_t start = nanoresource_clock_now();
+
+  for (uint64_t r = 0; r < rounds; ++r) {
+    for (unsigned int i = 0; i < depth; ++i) {
+      nanoresource_queue_push(&resource, &requests[i]);
+    }
+
+    for (unsigned int i = 0; i < depth; ++i) {
+      nanoresource_queue_shift(&resource);
+    }
+  }
+
+  snprintf(params, sizeof(params), "\"depth\":%u", depth);
+  bench_report("queue.push_shift", params, rounds * depth,
+    nanoresource_clock_now() - start);
+}
+
+static void *
+hooked_alloc(unsigned long int size) {
+  return malloc(size);
+}
+
+static void
+hooked_free(void *ptr) {
+  free(ptr);
+}
+
+static void
+bench_allocator(const char *name, int hooked) {
+  const uint64_t ops = BENCH_ITERATIONS;
+
+  nanoresource_allocator_set(hooked ? hooked_alloc : 0);
+  nanoresource_deallocator_set(hooked ? hooked_free : 0);
+
+  uint64_t start = nanoresource_clock_now();
+
+  for (uint64_t i = 0; i < ops; ++i) {
+    nanoresource_allocator_free(
+      nanoresource_allocator_alloc(sizeof(struct nanoresource_request_s)));
+  }
+
+  bench_report(name, 0, ops, nanoresource_clock_now() - start);
+
+  nanoresource_allocator_set(0);
+  nanoresource_deallocator_set(0);
+}
+
+static void
+bench_malloc(void) {
+  const uint64_t ops = BENCH_ITERATIONS;
+  uint64_t start = nanoresource_clock_now();
+
+  for (uint64_t i = 0; i < ops; ++i) {
+    void *volatile ptr = malloc(sizeof(struct nanoresource_request_s));
+    free(ptr);
+  }
+
+  bench_report("allocator.malloc", 0, ops, nanoresource_clock_now() - start);
+}
+
+struct worker_s {
+  pthread_t thread;
+  pthread_mutex_t *lock;
+  struct nanoresource_s *resource;
+  uint64_t ops;
+};
+
+static void *
+work(void *arg) {
+  struct worker_s *worker = arg;
+  struct nanoresource_request_s request;
+
+  // stack requests keep the allocator (and its unsynchronized
+  // stats) out of the measurement
+  for (uint64_t i = 0; i < worker->ops; ++i) {
+    if (0 != worker->lock) {
+      pthread_mutex_lock(worker->lock);
+    }
+
+    nanoresource_request_init(&request,
+      (struct nanoresource_request_options_s) {
+        .type = NANORESOURCE_REQUEST_USER,
+        .resource = worker->resource,
+        .user = complete
+      });
+
+    nanoresource_submit(worker->resource, &request);
+
+    if (0 != worker->lock) {
+      pthread_mutex_unlock(worker->lock);
+    }
+  }
+
+  return 0;
+}
+
+static void
+bench_threads(unsigned int count, int shared) {
+  const uint64_t ops = BENCH_ITERATIONS / count;
+  struct worker_s workers[MAX_THREADS];
+  struct nanoresource_s resources[MAX_THREADS];
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  char params[48] = { 0 };
+
+  for (unsigned int i = 0; i < count; ++i) {
+    nanoresource_init(&resources[i], (struct nanoresource_options_s) { 0 });
+    nanoresource_open(&resources[i], 0);
+    workers[i] = (struct worker_s) {
+      .lock = shared ? &lock : 0,
+      .resource = shared ? &resources[0] : &resources[i],
+      .ops = ops
+    };
+  }
+
+  uint64_t start = nanoresource_clock_now();
+
+  for (unsigned int i = 0; i < count; ++i) {
+    pthread_create(&workers[i].thread, 0, work, &workers[i]);
+  }
+
+  for (unsigned int i = 0; i < count; ++i) {
+    pthread_join(workers[i].thread, 0);
+  }
+
+  snprintf(params, sizeof(params), "\"threads\":%u,\"shared\":%s",
+    count, shared ? "true" : "false");
+
+  bench_report("threads.complete", params, ops * count,
+    nanoresource_clock_now() - start);
+}
+
+int
+main(void) {
+  static const unsigned int depths[] = { 1, 8, 64, 256 };
+  static const unsigned int threads[] = { 1, 2, 4, 8 };
+
+  bench_lifecycle();
+
+  for (unsigned int i = 0; i < sizeof(depths) / sizeof(*depths); ++i) {
+    bench_user(depths[i]);
+  }
+
+  for (unsigned int i = 0; i < sizeof(depths) / sizeof(*depths); ++i) {
+    bench_queue(depths[i]);
+  }
+
+  bench_malloc();
+  bench_allocator("allocator.default", 0);
+  bench_allocator("allocator.hooked", 1);
+
+  for (unsigned int i = 0; i < sizeof(threads) / sizeof(*threads); ++i) {
+    bench_threads(threads[i], 0);
+    bench_threads(threads[i], 1);
+  }
+
+  return 0;
+}
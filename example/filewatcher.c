@@ -1,242 +1,72 @@
-#include <nanoresource/nanoresource.h>
-#include <sys/stat.h>
+#include "watcher.h"
 #include <pthread.h>
-#include <assert.h>
-#include <stdlib.h>
-#include <string.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <errno.h>
 #include <stdio.h>
-#include <time.h>
 
-#define MAX_THREADS 16
-#define SHARED_MEMORY_BYTES 64
+#define MAX_CHANGES 2
+#define DEBOUNCE_MS 50
 
-typedef struct thread_s thread_t;
-typedef struct thread_context_s thread_context_t;
-typedef struct watch_context_s watch_context_t;
-
-typedef void *(pthread_start_routine_t)(void *);
-typedef void (watch_callback_t)(nanoresource_t *resource, int err);
-typedef void (watch_change_callback_t)(
-  nanoresource_t *resource,
-  const char *filename,
-  const struct stat *stats);
-
-struct thread_s {
-  pthread_t id;
-  pthread_attr_t attr;
-  unsigned int index;
-  nanoresource_request_t *request;
-};
-
-struct thread_context_s {
-  thread_t **threads;
-  unsigned int count;
-};
-
-struct watch_context_s {
-  const char *filename;
-  watch_change_callback_t *onchange;
-};
-
-static void
-forward(nanoresource_request_t *request, pthread_start_routine_t *start) {
-  thread_context_t *context = (thread_context_t *) request->resource->data;
-  thread_t **threads = context->threads;
-  thread_t *thread = malloc(sizeof(*thread));
-
-  *thread = (thread_t){ 0 };
-  thread->index = context->count;
-  thread->request = request;
-  context->threads[context->count++] = thread;
-
-  pthread_attr_init(&thread->attr);
-  pthread_create(&thread->id, &thread->attr, start, thread);
-}
-
-static void *
-open_resource_thread(void *arg) {
-  thread_t *thread = (thread_t *) arg;
-  nanoresource_request_t *request = thread->request;
-  thread_context_t *context = (thread_context_t *) request->resource->data;
-
-  printf("opening...\n");
-  request->callback(request, 0);
-
-  pthread_exit(0);
-  return 0;
-}
-
-static void *
-close_resource_thread(void *arg) {
-  thread_t *thread = (thread_t *) arg;
-  nanoresource_request_t *request = thread->request;
-  thread_context_t *context = (thread_context_t *) request->resource->data;
-
-  printf("closing...\n");
-  request->callback(request, 0);
-
-  pthread_exit(0);
-  return 0;
-}
-
-static void *
-destroy_resource_thread(void *arg) {
-  thread_t *thread = (thread_t *) arg;
-  nanoresource_request_t *request = thread->request;
-  thread_context_t *context = (thread_context_t *) request->resource->data;
-
-  printf("destroying...\n");
-  request->callback(request, 0);
-  pthread_exit(0);
-  return 0;
-}
-
-static void *
-watch_resource_thread(void *arg) {
-  thread_t *thread = (thread_t *) arg;
-  nanoresource_request_t *request = thread->request;
-  thread_context_t *context = (thread_context_t *) request->resource->data;
-
-  watch_context_t *ctx = request->data;
-  const char *filename = ctx->filename;
-  unsigned int changes = 0;
-  unsigned int max = 2;
-  time_t now = time(0);
-
-  printf("watching... %s\n", ctx->filename);
-  while (changes < max) {
-    sleep(1);
-
-    struct stat stats = { 0 };
-    stat(filename, &stats);
-
-    if (stats.st_mtim.tv_sec > now) {
-      (void) changes++;
-      now = time(0);
-      ctx->onchange(request->resource, ctx->filename, &stats);
-    }
-  }
-
-
-  request->callback(request, 0);
-  pthread_exit(0);
-  return 0;
-}
-
-static void
-open_resource(nanoresource_request_t *request) {
-  forward(request, open_resource_thread);
-}
-
-static void
-close_resource(nanoresource_request_t *request) {
-  forward(request, close_resource_thread);
-}
-
-static void
-destroy_resource(nanoresource_request_t *request) {
-  forward(request, destroy_resource_thread);
-}
-
-static void
-watch_resource(nanoresource_request_t *request) {
-  forward(request, watch_resource_thread);
-}
-
-static int
-watch_after(
-  struct nanoresource_request_s *request,
-  unsigned int err
-) {
-  free(request->data);
-  free(request);
-  return 0;
-}
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static unsigned int changes = 0;
 
 static void
-watch(
-  nanoresource_t *resource,
+onchange(
+  watcher_t *watcher,
   const char *filename,
-  watch_callback_t *callback,
-  watch_change_callback_t *onchange
+  const struct stat *stats,
+  void *data
 ) {
-  watch_context_t *ctx = malloc(sizeof(*ctx));
-  *ctx = (watch_context_t){ filename, onchange };
-
-  nanoresource_request_t *request = nanoresource_request_new(
-    (nanoresource_request_options_t) {
-      .callback = callback,
-      .resource = resource,
-      .type = NANORESOURCE_REQUEST_USER,
-      .user = watch_resource,
-      .after = watch_after,
-      .data = (void *) ctx
-    });
-
-  nanoresource_request_run(request);
-}
+  printf("change! %s (%lld bytes)\n", filename, (long long) stats->st_size);
 
-static void
-onclose(nanoresource_t *resource, int err) {
-  printf("onclose(err=%d)\n", err);
+  pthread_mutex_lock(&lock);
+  (void) changes++;
+  pthread_cond_signal(&changed);
+  pthread_mutex_unlock(&lock);
 }
 
 static void
-ondestroy(nanoresource_t *resource, int err) {
-  printf("ondestroy(err=%d)\n", err);
-}
+watch(watcher_t *watcher, const char *filename) {
+  int wd = watcher_add(watcher, filename, onchange, 0);
 
-static void
-onwatch(nanoresource_t *resource, int err) {
-  printf("onwatch(err=%d)\n", err);
-  nanoresource_destroy(resource, ondestroy);
+  if (wd < 0) {
+    printf("watch(%s, err=%d)\n", filename, -wd);
+  } else {
+    printf("watching... %s\n", filename);
+  }
 }
 
 static void
-onchange(
-  nanoresource_t *resource,
-  const char *filename,
-  const struct stat *stats
-) {
-  printf("change!\n");
+onopen(nanoresource_t *resource, int err) {
+  printf("onopen(err=%d)\n", err);
 }
 
 static void
-onopen(nanoresource_t *resource, int err) {
-  printf("onopen(err=%d)\n", err);
-  watch(resource, "Makefile", onwatch, onchange);
+ondestroy(nanoresource_t *resource, int err) {
+  printf("ondestroy(err=%d)\n", err);
 }
 
 int
-main(void) {
-  thread_context_t context = { 0 };
-  nanoresource_t resource = { 0 };
-
-  context.threads = malloc(MAX_THREADS * sizeof(context.threads));
-  memset(context.threads, 0, sizeof(*context.threads));
+main(int argc, char **argv) {
+  watcher_t watcher;
 
-  nanoresource_init(&resource,
-    (nanoresource_options_t) {
-      .data = &context,
-      .open = open_resource,
-      .close = close_resource,
-      .destroy = destroy_resource
-    });
+  watcher_init(&watcher, (watcher_options_t) { .debounce = DEBOUNCE_MS });
+  watcher_open(&watcher, onopen);
 
-  const char *buffer = "hello";
-  nanoresource_open(&resource, onopen);
+  // every path is multiplexed on the one watcher thread
+  for (int i = 1; i < argc; ++i) {
+    watch(&watcher, argv[i]);
+  }
 
-  for (int i = 0; i < context.count; ++i) {
-    thread_t *thread = context.threads[i];
-    pthread_join(thread->id, 0);
-    context.threads[i] = 0;
-    free(thread);
+  if (argc < 2) {
+    watch(&watcher, "Makefile");
   }
 
+  pthread_mutex_lock(&lock);
+  while (changes < MAX_CHANGES) {
+    pthread_cond_wait(&changed, &lock);
+  }
+  pthread_mutex_unlock(&lock);
 
-  free(context.threads);
+  watcher_destroy(&watcher, ondestroy);
   return 0;
 }
@@ -0,0 +1,473 @@
+#include "watcher.h"
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+
+#define WATCH_MASK (                                                      \
+  IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF)
+
+static watcher_entry_t *
+lookup(watcher_t *watcher, int wd) {
+  if (wd < 0 || (unsigned int) wd >= watcher->capacity) {
+    return 0;
+  }
+
+  return watcher->entries[wd];
+}
+
+// queued changes refer to an entry by its id as its watch descriptor
+// changes when the path is replaced
+static watcher_entry_t *
+find(watcher_t *watcher, unsigned long int id) {
+  for (unsigned int i = 0; i < watcher->capacity; ++i) {
+    if (0 != watcher->entries[i] && id == watcher->entries[i]->id) {
+      return watcher->entries[i];
+    }
+  }
+
+  return 0;
+}
+
+static int
+reserve(watcher_t *watcher, int wd) {
+  unsigned int capacity = watcher->capacity > 0 ? watcher->capacity : 16;
+
+  while ((unsigned int) wd >= capacity) {
+    capacity *= 2;
+  }
+
+  if (capacity != watcher->capacity) {
+    watcher_entry_t **entries = realloc(
+      watcher->entries,
+      capacity * sizeof(*entries));
+
+    if (0 == entries) {
+      return -ENOMEM;
+    }
+
+    memset(
+      entries + watcher->capacity,
+      0,
+      (capacity - watcher->capacity) * sizeof(*entries));
+
+    watcher->entries = entries;
+    watcher->capacity = capacity;
+  }
+
+  return 0;
+}
+
+static void
+unlink_dirty(watcher_t *watcher, watcher_entry_t *entry) {
+  watcher_entry_t *previous = 0;
+
+  if (0 == entry->dirty) {
+    return;
+  }
+
+  for (watcher_entry_t *it = watcher->dirty; 0 != it; it = it->next) {
+    if (entry == it) {
+      if (0 == previous) {
+        watcher->dirty = it->next;
+      } else {
+        previous->next = it->next;
+      }
+
+      if (watcher->dirty_tail == it) {
+        watcher->dirty_tail = previous;
+      }
+
+      break;
+    }
+
+    previous = it;
+  }
+
+  entry->dirty = 0;
+  entry->next = 0;
+}
+
+static void
+release(watcher_t *watcher, watcher_entry_t *entry) {
+  unlink_dirty(watcher, entry);
+  watcher->entries[entry->wd] = 0;
+  free(entry->filename);
+  free(entry);
+}
+
+// coalesce bursts, the first event starts the debounce window
+static void
+touch(watcher_t *watcher, watcher_entry_t *entry) {
+  if (1 == entry->dirty) {
+    return;
+  }
+
+  entry->dirty = 1;
+  entry->deadline = nanoresource_clock_now() +
+    (uint64_t) watcher->options.debounce * 1000000u;
+
+  if (0 == watcher->dirty_tail) {
+    watcher->dirty = entry;
+  } else {
+    watcher->dirty_tail->next = entry;
+  }
+
+  watcher->dirty_tail = entry;
+}
+
+static void
+mark(watcher_t *watcher, const struct inotify_event *event) {
+  watcher_entry_t *entry = lookup(watcher, event->wd);
+
+  if (0 == entry) {
+    return;
+  }
+
+  // the file was deleted or replaced (ie: saved by an editor), so watch
+  // whatever the path points to now
+  if (event->mask & IN_IGNORED) {
+    int wd = inotify_add_watch(watcher->fd, entry->filename, WATCH_MASK);
+
+    if (wd < 0 || reserve(watcher, wd) < 0 || 0 != watcher->entries[wd]) {
+      release(watcher, entry);
+      return;
+    }
+
+    watcher->entries[entry->wd] = 0;
+    watcher->entries[wd] = entry;
+    entry->wd = wd;
+  }
+
+  touch(watcher, entry);
+}
+
+static void
+deliver(nanoresource_request_t *request) {
+  watcher_t *watcher = request->resource->data;
+  unsigned long int *id = nanoresource_request_payload(request);
+  struct stat stats = { 0 };
+
+  pthread_mutex_lock(&watcher->lock);
+
+  // the path may have been removed since the change was queued, and there
+  // is no payload when compiled with `NANORESOURCE_REQUEST_PAYLOAD_SIZE=0`
+  watcher_entry_t *entry = 0 != id ? find(watcher, *id) : 0;
+
+  if (0 != entry && 0 != entry->onchange) {
+    stat(entry->filename, &stats);
+    entry->onchange(watcher, entry->filename, &stats, entry->data);
+  }
+
+  request->callback(request, 0);
+  pthread_mutex_unlock(&watcher->lock);
+}
+
+// delivers changes past their debounce window, returning the number of
+// milliseconds until the next one is due or `-1` if there are none. A change
+// that cannot be queued is marked dirty again and retried a window later
+static int
+flush(watcher_t *watcher) {
+  uint64_t now = nanoresource_clock_now();
+
+  // entries share one window so the list is ordered by deadline, and one
+  // marked again goes to its tail
+  while (0 != watcher->dirty && watcher->dirty->deadline <= now) {
+    watcher_entry_t *entry = watcher->dirty;
+
+    watcher->dirty = entry->next;
+    entry->next = 0;
+    entry->dirty = 0;
+
+    if (0 == watcher->dirty) {
+      watcher->dirty_tail = 0;
+    }
+
+    nanoresource_request_t *request = nanoresource_request_new(
+      (nanoresource_request_options_t) {
+        .type = NANORESOURCE_REQUEST_USER,
+        .resource = &watcher->resource,
+        .user = deliver,
+        .payload = &entry->id,
+        .payload_size = sizeof(entry->id)
+      });
+
+    if (0 == request) {
+      touch(watcher, entry);
+    } else if (nanoresource_queue_push(&watcher->resource, request) < 0) {
+      nanoresource_request_free(request);
+      touch(watcher, entry);
+    } else if (1 == nanoresource_request_runnable(request)) {
+      nanoresource_request_run(request);
+    }
+  }
+
+  if (0 == watcher->dirty) {
+    return -1;
+  }
+
+  return (int) ((watcher->dirty->deadline - now + 999999u) / 1000000u);
+}
+
+static void *
+run(void *arg) {
+  watcher_t *watcher = arg;
+  char buffer[4096]
+    __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+  struct pollfd fds[2] = {
+    { .fd = watcher->fd, .events = POLLIN },
+    { .fd = watcher->wakeup, .events = POLLIN },
+  };
+
+  for (;;) {
+    pthread_mutex_lock(&watcher->lock);
+    int timeout = flush(watcher);
+    pthread_mutex_unlock(&watcher->lock);
+
+    if (poll(fds, 2, timeout) < 0 && EINTR != errno) {
+      break;
+    }
+
+    if (fds[1].revents & POLLIN) {
+      break;
+    }
+
+    if (0 == (fds[0].revents & POLLIN)) {
+      continue;
+    }
+
+    ssize_t size = read(watcher->fd, buffer, sizeof(buffer));
+
+    pthread_mutex_lock(&watcher->lock);
+
+    for (char *it = buffer; size > 0 && it < buffer + size;) {
+      const struct inotify_event *event = (const struct inotify_event *) it;
+      mark(watcher, event);
+      it += sizeof(struct inotify_event) + event->len;
+    }
+
+    pthread_mutex_unlock(&watcher->lock);
+  }
+
+  pthread_mutex_lock(&watcher->lock);
+
+  for (unsigned int i = 0; i < watcher->capacity; ++i) {
+    if (0 != watcher->entries[i]) {
+      release(watcher, watcher->entries[i]);
+    }
+  }
+
+  close(watcher->fd);
+  close(watcher->wakeup);
+  watcher->fd = -1;
+  watcher->wakeup = -1;
+
+  // complete the close request waiting for the thread to stop
+  nanoresource_request_t *request = watcher->closing;
+  watcher->closing = 0;
+
+  if (0 != request) {
+    request->callback(request, 0);
+  }
+
+  pthread_mutex_unlock(&watcher->lock);
+  return 0;
+}
+
+static void
+open_watcher(nanoresource_request_t *request) {
+  watcher_t *watcher = request->resource->data;
+  int err = 0;
+
+  // a previous thread completed its close request and is exiting
+  if (1 == watcher->joinable) {
+    if (pthread_equal(pthread_self(), watcher->thread)) {
+      pthread_detach(watcher->thread);
+    } else {
+      pthread_join(watcher->thread, 0);
+    }
+
+    watcher->joinable = 0;
+  }
+
+  watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  watcher->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if (watcher->fd < 0 || watcher->wakeup < 0) {
+    err = errno;
+  } else if (0 == (err = pthread_create(&watcher->thread, 0, run, watcher))) {
+    watcher->joinable = 1;
+  }
+
+  if (0 != err) {
+    if (watcher->fd >= 0) {
+      close(watcher->fd);
+    }
+
+    if (watcher->wakeup >= 0) {
+      close(watcher->wakeup);
+    }
+
+    watcher->fd = -1;
+    watcher->wakeup = -1;
+  }
+
+  request->callback(request, err);
+}
+
+static void
+close_watcher(nanoresource_request_t *request) {
+  watcher_t *watcher = request->resource->data;
+  uint64_t value = 1;
+
+  watcher->closing = request;
+
+  if (write(watcher->wakeup, &value, sizeof(value)) < 0) {
+    watcher->closing = 0;
+    request->callback(request, errno);
+  }
+}
+
+static void
+destroy_watcher(nanoresource_request_t *request) {
+  watcher_t *watcher = request->resource->data;
+
+  free(watcher->entries);
+  watcher->entries = 0;
+  watcher->capacity = 0;
+
+  request->callback(request, 0);
+}
+
+int
+watcher_init(watcher_t *watcher, watcher_options_t options) {
+  pthread_mutexattr_t attr;
+
+  memset(watcher, 0, sizeof(*watcher));
+  watcher->options = options;
+  watcher->fd = -1;
+  watcher->wakeup = -1;
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&watcher->lock, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  return nanoresource_init(&watcher->resource,
+    (nanoresource_options_t) {
+      .data = watcher,
+      .open = open_watcher,
+      .close = close_watcher,
+      .destroy = destroy_watcher
+    });
+}
+
+int
+watcher_open(watcher_t *watcher, nanoresource_open_callback_t *callback) {
+  pthread_mutex_lock(&watcher->lock);
+  int err = nanoresource_open(&watcher->resource, callback);
+  pthread_mutex_unlock(&watcher->lock);
+  return err;
+}
+
+int
+watcher_close(watcher_t *watcher, nanoresource_close_callback_t *callback) {
+  pthread_mutex_lock(&watcher->lock);
+  int err = nanoresource_close(&watcher->resource, callback);
+  pthread_mutex_unlock(&watcher->lock);
+  return err;
+}
+
+int
+watcher_destroy(
+  watcher_t *watcher,
+  nanoresource_destroy_callback_t *callback
+) {
+  pthread_mutex_lock(&watcher->lock);
+  int err = nanoresource_destroy(&watcher->resource, callback);
+  pthread_mutex_unlock(&watcher->lock);
+
+  if (1 == watcher->joinable) {
+    pthread_join(watcher->thread, 0);
+    watcher->joinable = 0;
+  }
+
+  pthread_mutex_destroy(&watcher->lock);
+  return err;
+}
+
+int
+watcher_add(
+  watcher_t *watcher,
+  const char *filename,
+  watcher_change_callback_t *onchange,
+  void *data
+) {
+  watcher_entry_t *entry = 0;
+  int wd = -ENOLCK;
+
+  pthread_mutex_lock(&watcher->lock);
+
+  if (watcher->fd < 0) {
+    goto done;
+  }
+
+  if ((wd = inotify_add_watch(watcher->fd, filename, WATCH_MASK)) < 0) {
+    wd = -errno;
+    goto done;
+  }
+
+  if (0 != (entry = lookup(watcher, wd))) {
+    entry->onchange = onchange;
+    entry->data = data;
+    goto done;
+  }
+
+  if (0 != (entry = calloc(1, sizeof(*entry)))) {
+    entry->filename = strdup(filename);
+  }
+
+  if (0 == entry || 0 == entry->filename || reserve(watcher, wd) < 0) {
+    inotify_rm_watch(watcher->fd, wd);
+
+    if (0 != entry) {
+      free(entry->filename);
+    }
+
+    free(entry);
+    wd = -ENOMEM;
+    goto done;
+  }
+
+  entry->wd = wd;
+  entry->id = ++watcher->ids;
+  entry->onchange = onchange;
+  entry->data = data;
+  watcher->entries[wd] = entry;
+
+done:
+  pthread_mutex_unlock(&watcher->lock);
+  return wd;
+}
+
+int
+watcher_remove(watcher_t *watcher, int wd) {
+  int err = -ENOENT;
+
+  pthread_mutex_lock(&watcher->lock);
+
+  watcher_entry_t *entry = lookup(watcher, wd);
+
+  if (0 != entry) {
+    inotify_rm_watch(watcher->fd, wd);
+    release(watcher, entry);
+    err = 0;
+  }
+
+  pthread_mutex_unlock(&watcher->lock);
+  return err;
+}
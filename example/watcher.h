@@ -0,0 +1,108 @@
+#ifndef WATCHER_H
+#define WATCHER_H
+
+#include <nanoresource/nanoresource.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <stdint.h>
+
+typedef struct watcher_s watcher_t;
+typedef struct watcher_options_s watcher_options_t;
+typedef struct watcher_entry_s watcher_entry_t;
+
+/**
+ * Called with the current `stat()` of a watched path after it changed.
+ */
+typedef void (watcher_change_callback_t)(
+  watcher_t *watcher,
+  const char *filename,
+  const struct stat *stats,
+  void *data);
+
+/**
+ * Events for a path within `debounce` milliseconds of the first one are
+ * coalesced into a single change.
+ */
+struct watcher_options_s {
+  unsigned long int debounce;
+};
+
+/**
+ * A watched path, indexed by its inotify watch descriptor. The descriptor
+ * changes when the path is replaced, so queued changes use its `id`.
+ */
+struct watcher_entry_s {
+  int wd;
+  unsigned long int id;
+  int dirty;
+  uint64_t deadline;
+  char *filename;
+  watcher_change_callback_t *onchange;
+  void *data;
+  watcher_entry_t *next;
+};
+
+/**
+ * A resource multiplexing every watched path on one inotify file
+ * descriptor and one thread. Changes are delivered as user requests on the
+ * resource so they are serialized with its lifecycle. Calls are guarded by
+ * a (recursive) lock, so they can be made from any thread, including from
+ * `onchange` callbacks.
+ */
+struct watcher_s {
+  nanoresource_t resource;
+  watcher_options_t options;
+  pthread_mutex_t lock;
+  pthread_t thread;
+  int joinable;
+  int fd;
+  int wakeup;
+  nanoresource_request_t *closing;
+  watcher_entry_t **entries;
+  unsigned int capacity;
+  unsigned long int ids;
+  watcher_entry_t *dirty;
+  watcher_entry_t *dirty_tail;
+};
+
+int
+watcher_init(watcher_t *watcher, watcher_options_t options);
+
+/**
+ * Creates the inotify file descriptor and starts the watcher thread.
+ */
+int
+watcher_open(watcher_t *watcher, nanoresource_open_callback_t *callback);
+
+/**
+ * Stops the watcher thread and removes every watch.
+ */
+int
+watcher_close(watcher_t *watcher, nanoresource_close_callback_t *callback);
+
+/**
+ * Closes and destroys the watcher, waiting for its thread to exit. Must not
+ * be called from the watcher thread (ie: from an `onchange` callback).
+ */
+int
+watcher_destroy(watcher_t *watcher, nanoresource_destroy_callback_t *callback);
+
+/**
+ * Watches a path on an opened watcher, returning its watch descriptor or an
+ * error code found in `errno.h` with its sign flipped. Watching the same
+ * file twice replaces its callback.
+ */
+int
+watcher_add(
+  watcher_t *watcher,
+  const char *filename,
+  watcher_change_callback_t *onchange,
+  void *data);
+
+/**
+ * Stops watching a path by its watch descriptor.
+ */
+int
+watcher_remove(watcher_t *watcher, int wd);
+
+#endif
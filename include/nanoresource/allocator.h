@@ -3,6 +3,10 @@
 
 #include "platform.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Forward declarations
 struct nanoresource_allocator_stats_s;
 
@@ -60,4 +64,8 @@ nanoresource_allocator_alloc(unsigned long int);
 NANORESOURCE_EXPORT void
 nanoresource_allocator_free(void *);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
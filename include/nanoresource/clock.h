@@ -0,0 +1,22 @@
+#ifndef NANORESOURCE_CLOCK_H
+#define NANORESOURCE_CLOCK_H
+
+#include "platform.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Returns a monotonic timestamp in nanoseconds. The value is only
+ * meaningful when compared to other values returned by this function.
+ */
+NANORESOURCE_EXPORT uint64_t
+nanoresource_clock_now();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef NANORESOURCE_COROUTINE_HPP
+#define NANORESOURCE_COROUTINE_HPP
+
+#include "nanoresource.hpp"
+#include <atomic>
+#include <coroutine>
+#include <exception>
+
+/**
+ * C++20 coroutine support for libnanoresource. Awaiting an operation
+ * queues a `struct nanoresource_request_s` that lives inside the awaiter,
+ * and therefore inside the coroutine frame, so awaiting allocates nothing
+ * beyond the frame itself. Every `co_await` evaluates to the error code of
+ * the request (`0` on success).
+ *
+ *   nanoresource::task
+ *   job(nanoresource::async res) {
+ *     if (0 == co_await res.open()) {
+ *       co_await res.run([](nanoresource::request r) { r.done(); });
+ *       co_await res.close();
+ *     }
+ *   }
+ */
+namespace nanoresource {
+
+namespace detail {
+
+template <typename Work>
+class awaiter {
+  public:
+    awaiter(nanoresource_s *resource, nanoresource_request_type type, Work work)
+      : resource_(resource), type_(type), work_(std::move(work)) {}
+
+    awaiter(const awaiter &) = delete;
+    awaiter &operator=(const awaiter &) = delete;
+
+    bool
+    await_ready() const noexcept {
+      return nullptr == resource_;
+    }
+
+    bool
+    await_suspend(std::coroutine_handle<> handle) noexcept {
+      nanoresource_request_options_s options = {};
+      int err = 0;
+
+      handle_ = handle;
+      options.type = type_;
+      options.resource = resource_;
+      options.user = NANORESOURCE_REQUEST_USER == type_ ? run : nullptr;
+      options.after = after;
+      options.data = this;
+
+      nanoresource_request_init(&request_, options);
+
+      // destroy implies close, see `nanoresource_destroy()`
+      if (NANORESOURCE_REQUEST_DESTROY == type_) {
+        err = nanoresource_close(resource_, nullptr);
+      }
+
+      if (0 == err) {
+        err = nanoresource_queue_push(resource_, &request_);
+      }
+
+      if (err < 0) {
+        err_ = -err;
+        return false;
+      }
+
+      if (1 == nanoresource_request_runnable(&request_)) {
+        nanoresource_request_run(&request_);
+      }
+
+      // do not suspend when the request completed synchronously
+      return completed != state_.exchange(suspended);
+    }
+
+    int
+    await_resume() const noexcept {
+      return nullptr == resource_ ? EFAULT : err_;
+    }
+
+  private:
+    enum { pending = 0, suspended = 1, completed = 2 };
+
+    static void
+    run(nanoresource_request_s *handle) {
+      static_cast<awaiter *>(handle->data)->work_(request(handle));
+    }
+
+    static int
+    after(nanoresource_request_s *handle, unsigned int err) {
+      auto *self = static_cast<awaiter *>(handle->data);
+
+      self->err_ = static_cast<int>(err);
+
+      // the frame (and `self`) may be destroyed by the resumed coroutine
+      if (suspended == self->state_.exchange(completed)) {
+        self->handle_.resume();
+      }
+
+      return 0;
+    }
+
+    nanoresource_request_s request_ = {};
+    nanoresource_s *resource_;
+    nanoresource_request_type type_;
+    Work work_;
+    std::coroutine_handle<> handle_ = {};
+    std::atomic<int> state_ = { pending };
+    int err_ = 0;
+};
+
+} // namespace detail
+
+/**
+ * A non-owning view of a resource with awaitable operations.
+ */
+class async {
+  public:
+    async(nanoresource_s *resource) noexcept
+      : resource_(resource) {}
+
+    template <typename Impl>
+    async(const resource<Impl> &owner) noexcept
+      : resource_(owner.get()) {}
+
+    detail::awaiter<detail::complete>
+    open() const noexcept {
+      return { resource_, NANORESOURCE_REQUEST_OPEN, detail::complete() };
+    }
+
+    detail::awaiter<detail::complete>
+    close() const noexcept {
+      return { resource_, NANORESOURCE_REQUEST_CLOSE, detail::complete() };
+    }
+
+    /**
+     * Closes and destroys the resource. The memory of the resource is not
+     * released; that is left to its owner.
+     */
+    detail::awaiter<detail::complete>
+    destroy() const noexcept {
+      return { resource_, NANORESOURCE_REQUEST_DESTROY, detail::complete() };
+    }
+
+    /**
+     * Queues user work `work(request)` that completes when the work calls
+     * `request::done()`.
+     */
+    template <typename Work>
+    detail::awaiter<Work>
+    run(Work work) const noexcept {
+      return { resource_, NANORESOURCE_REQUEST_USER, std::move(work) };
+    }
+
+    nanoresource_s *
+    get() const noexcept {
+      return resource_;
+    }
+
+  private:
+    nanoresource_s *resource_;
+};
+
+/**
+ * A minimal eagerly started, detached coroutine type for driving
+ * awaitable resource operations.
+ */
+struct task {
+  struct promise_type {
+    task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+} // namespace nanoresource
+
+#endif
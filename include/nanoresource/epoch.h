@@ -0,0 +1,125 @@
+#ifndef NANORESOURCE_EPOCH_H
+#define NANORESOURCE_EPOCH_H
+
+#include "platform.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The number of retired pointers a thread keeps before it tries to advance
+ * the global epoch and release what is safe to release.
+ */
+#ifndef NANORESOURCE_EPOCH_BATCH
+#define NANORESOURCE_EPOCH_BATCH 64
+#endif
+
+/**
+ * The `nanoresource_epoch_free_callback_t` callback releases a retired
+ * pointer once no reader can observe it anymore.
+ */
+typedef void (nanoresource_epoch_free_callback_t)(void *pointer);
+
+/**
+ * Represents a retired pointer waiting to be released. Nodes are intrusive
+ * and owned by the caller, usually stored in the retired memory itself, so
+ * retiring a pointer never allocates.
+ */
+struct nanoresource_epoch_node_s {
+  struct nanoresource_epoch_node_s *next;
+  uint64_t epoch;
+  void *pointer;
+  nanoresource_epoch_free_callback_t *callback;
+};
+
+/**
+ * The node of a retired resource or request, only present when compiled
+ * with `NANORESOURCE_EPOCHS` defined.
+ */
+#ifdef NANORESOURCE_EPOCHS
+#define NANORESOURCE_EPOCH_FIELDS \
+  struct nanoresource_epoch_node_s retired;
+#else
+#define NANORESOURCE_EPOCH_FIELDS
+#endif
+
+/**
+ * Enters a read side critical section on the calling thread. Memory retired
+ * with `nanoresource_epoch_retire()` is not released while a thread that
+ * could have observed it is in a critical section, so readers can inspect
+ * resources and requests of other threads without locks, ie:
+ *
+ *   nanoresource_epoch_enter();
+ *   struct nanoresource_s *resource = nanoresource_handle_get(handles, h);
+ *   int opened = 0 != resource && 1 == resource->opened;
+ *   nanoresource_epoch_leave();
+ *
+ * Critical sections can be nested and should be short, they hold back
+ * reclamation on every thread.
+ */
+NANORESOURCE_EXPORT void
+nanoresource_epoch_enter();
+
+/**
+ * Leaves a read side critical section on the calling thread.
+ */
+NANORESOURCE_EXPORT void
+nanoresource_epoch_leave();
+
+/**
+ * Retires a pointer that is no longer reachable by new readers, calling
+ * `callback` with it once every reader that could have observed it has left
+ * its critical section. The `node` links the pointer in the limbo list of
+ * the calling thread until then, so it must stay valid until `callback` is
+ * called. When the library is compiled with `NANORESOURCE_EPOCHS` freed
+ * resources and requests are retired with the node stored in them instead
+ * of being released right away. Returns `0` on success, otherwise an error
+ * code found in `errno.h` with its sign flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_epoch_node_s *node' or the
+ *     'nanoresource_epoch_free_callback_t *callback' is `NULL`
+ */
+NANORESOURCE_EXPORT int
+nanoresource_epoch_retire(
+  struct nanoresource_epoch_node_s *node,
+  void *pointer,
+  nanoresource_epoch_free_callback_t *callback);
+
+/**
+ * Tries to advance the global epoch and releases the pointers retired by
+ * the calling thread that are safe to release. Returns the number of
+ * pointers released.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_epoch_collect();
+
+/**
+ * Waits for every reader and releases all the pointers retired by the
+ * calling thread. Must not be called in a critical section. Returns the
+ * number of pointers released.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_epoch_synchronize();
+
+/**
+ * Releases all the pointers retired by the calling thread like
+ * `nanoresource_epoch_synchronize()` and gives its epoch record back so a
+ * thread entering its first critical section later reuses it instead of
+ * allocating one. Threads should call this before they exit. Returns the
+ * number of pointers released on success, otherwise an error code found in
+ * `errno.h` with its sign flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EBUSY`: The calling thread is in a critical section
+ */
+NANORESOURCE_EXPORT int
+nanoresource_epoch_release();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef NANORESOURCE_FILE_H
+#define NANORESOURCE_FILE_H
+
+#include "platform.h"
+#include "resource.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+struct nanoresource_file_s;
+struct nanoresource_file_map_s;
+struct nanoresource_file_slice_s;
+struct nanoresource_file_options_s;
+
+/**
+ * The access pattern hint given to the kernel for the mapping of a file
+ * with `posix_madvise()`.
+ */
+enum nanoresource_file_advice {
+  NANORESOURCE_FILE_NORMAL = 0,
+  NANORESOURCE_FILE_SEQUENTIAL = 1,
+  NANORESOURCE_FILE_RANDOM = 2
+};
+
+/**
+ * The `nanoresource_file_read_callback_t` callback represents the user
+ * callback for a file read request.
+ */
+typedef void (nanoresource_file_read_callback_t)(
+  struct nanoresource_file_s *file,
+  int err,
+  const struct nanoresource_file_slice_s *slice);
+
+/**
+ * A read only mapping of a file, one per generation of `resource.data`.
+ */
+struct nanoresource_file_map_s {
+  void *base;
+  size_t size;
+};
+
+/**
+ * A pinned range of a mapping. `length` is short at the end of the file.
+ */
+struct nanoresource_file_slice_s {
+  const void *data;
+  size_t length;
+  struct nanoresource_file_map_s *map;
+};
+
+/**
+ * Represents the initial configurable state for a file resource.
+ */
+struct nanoresource_file_options_s {
+  const char *filename;
+  enum nanoresource_file_advice advice;
+};
+
+/**
+ * Fields for `struct nanoresource_file_s` that can be used for extending
+ * structures that ensure correct memory layout. The resource is first so
+ * `struct nanoresource_s` pointers given to the operations can be cast.
+ */
+#define NANORESOURCE_FILE_FIELDS               \
+  struct nanoresource_s resource;              \
+  const char *filename;                        \
+  enum nanoresource_file_advice advice;        \
+  int fd;
+
+/**
+ * A resource whose `open` maps a file read only with `mmap()` (stored as a
+ * `struct nanoresource_file_map_s` in `resource.data`) and whose `close`
+ * unmaps it once the slices pinning it are released. Only available on
+ * POSIX platforms.
+ *
+ * The mapping is shared with the file, so truncating the file while
+ * slices are live raises `SIGBUS` on access to the pages past its new end.
+ */
+struct nanoresource_file_s {
+  NANORESOURCE_FILE_FIELDS
+};
+
+/**
+ * Initializes a pointer to `struct nanoresource_file_s`. Open, close, and
+ * destroy it like any other resource with `&file->resource`. Returns `0`
+ * on success, otherwise an error code found in `errno.h` with its sign
+ * flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_file_s *file' is `NULL`
+ *   * `EINVAL`: The filename is `NULL`
+ *   * `ENOSYS`: Memory mapped files are not supported on this platform
+ */
+NANORESOURCE_EXPORT int
+nanoresource_file_init(
+  struct nanoresource_file_s *file,
+  const struct nanoresource_file_options_s options);
+
+/**
+ * Queues a user request that reads `length` bytes at `offset` without
+ * copying, calling `callback(file, err, slice)` with a slice pointing into
+ * the mapping. The file is mapped again first if it grew past the mapping.
+ * The slice pins its mapping (like `nanoresource_acquire()`) and must be
+ * released with `nanoresource_file_release()`, when `err` is `0`. Returns
+ * `0` on success, otherwise an error code found in `errno.h` with its sign
+ * flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_file_s *file' is `NULL` or the
+ *     request could not be allocated
+ *   * `EAGAIN`: The resource queue is at its high watermark
+ *   * `ENOSYS`: Memory mapped files are not supported on this platform, or
+ *     the library was compiled with `NANORESOURCE_STATIC_POOLS`
+ *
+ * The callback is given `EBUSY` when the file grew but could not be
+ * mapped again because a previous mapping is still pinned by slices.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_file_read(
+  struct nanoresource_file_s *file,
+  uint64_t offset,
+  size_t length,
+  nanoresource_file_read_callback_t *callback);
+
+/**
+ * Releases a slice given to a read callback, unmapping its mapping if the
+ * file was mapped again since and this was its last user.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_file_release(
+  struct nanoresource_file_s *file,
+  const struct nanoresource_file_slice_s *slice);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef NANORESOURCE_HANDLE_H
+#define NANORESOURCE_HANDLE_H
+
+#include "observer.h"
+#include "platform.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+struct nanoresource_s;
+struct nanoresource_handles_s;
+struct nanoresource_handle_slot_s;
+
+/**
+ * A compact reference to a resource in a `struct nanoresource_handles_s`
+ * table made of a slot index (low 32 bits) and the generation of the slot
+ * (high 32 bits). The generation is never `0` so a `0` handle is never
+ * valid.
+ */
+typedef uint64_t nanoresource_handle_t;
+
+/**
+ * Represents a slot in a handle table. The observer releases the slot
+ * when the resource it maps to is destroyed.
+ */
+struct nanoresource_handle_slot_s {
+  struct nanoresource_s *resource;
+  uint32_t generation;
+  uint32_t next;
+  struct nanoresource_observer_s observer;
+};
+
+/**
+ * Fields for `struct nanoresource_handles_s` that can be used for
+ * extending structures that ensure correct memory layout.
+ */
+#define NANORESOURCE_HANDLES_FIELDS              \
+  struct nanoresource_handle_slot_s *slots;      \
+  uint32_t capacity;                             \
+  uint32_t size;                                 \
+  uint32_t free;                                 \
+  volatile int lock;
+
+/**
+ * Represents a fixed capacity table mapping handles to resources. Lookups
+ * with `nanoresource_handle_get()` are lock free and can be made from any
+ * thread, inserts and removals take a spin lock and must be made from the
+ * thread that owns the resource, like every other resource operation.
+ */
+struct nanoresource_handles_s {
+  NANORESOURCE_HANDLES_FIELDS
+};
+
+/**
+ * Initializes a pointer to `struct nanoresource_handles_s` allocating
+ * `capacity` slots with the library allocator. Returns `0` on success,
+ * otherwise an error code found in `errno.h` with its sign flipped and
+ * `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_handles_s *handles' is `NULL`
+ *   * `EINVAL`: The `capacity` is `0`
+ *   * `ENOMEM`: The slots could not be allocated
+ */
+NANORESOURCE_EXPORT int
+nanoresource_handles_init(
+  struct nanoresource_handles_s *handles,
+  uint32_t capacity);
+
+/**
+ * Releases every handle in the table and frees its slots. Resources are
+ * not destroyed.
+ */
+NANORESOURCE_EXPORT void
+nanoresource_handles_destroy(struct nanoresource_handles_s *handles);
+
+/**
+ * Inserts a resource into the table and returns its handle. The handle is
+ * released when the resource is destroyed, or with
+ * `nanoresource_handle_remove()`. Returns `0` on failure with `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_handles_s *handles' or
+ *     'struct nanoresource_s *resource' is `NULL`
+ *   * `ENOMEM`: The table is full
+ */
+NANORESOURCE_EXPORT nanoresource_handle_t
+nanoresource_handle_insert(
+  struct nanoresource_handles_s *handles,
+  struct nanoresource_s *resource);
+
+/**
+ * Returns the resource a handle maps to, or `0` with `errno` set. Lookups
+ * are lock free and never touch released memory. The resource itself is
+ * only valid until it is destroyed by its owner.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_handles_s *handles' is `NULL`
+ *   * `EINVAL`: The handle index is out of range
+ *   * `ESTALE`: The handle was released
+ */
+NANORESOURCE_EXPORT struct nanoresource_s *
+nanoresource_handle_get(
+  struct nanoresource_handles_s *handles,
+  nanoresource_handle_t handle);
+
+/**
+ * Releases a handle without destroying the resource. Returns `0` on
+ * success, otherwise an error code found in `errno.h` with its sign
+ * flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_handles_s *handles' is `NULL`
+ *   * `EINVAL`: The handle index is out of range
+ *   * `ESTALE`: The handle was already released
+ */
+NANORESOURCE_EXPORT int
+nanoresource_handle_remove(
+  struct nanoresource_handles_s *handles,
+  nanoresource_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef NANORESOURCE_HISTOGRAM_H
+#define NANORESOURCE_HISTOGRAM_H
+
+#include "platform.h"
+#include "request.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+struct nanoresource_s;
+struct nanoresource_histogram_s;
+
+/**
+ * The number of linear sub-buckets per power of two is
+ * `2^NANORESOURCE_HISTOGRAM_SUB_BUCKET_BITS`, which bounds the relative
+ * error of a recorded value to `1 / 2^NANORESOURCE_HISTOGRAM_SUB_BUCKET_BITS`.
+ */
+#ifndef NANORESOURCE_HISTOGRAM_SUB_BUCKET_BITS
+#define NANORESOURCE_HISTOGRAM_SUB_BUCKET_BITS 3
+#endif
+
+/**
+ * Values (in nanoseconds) at or above `2^NANORESOURCE_HISTOGRAM_MAGNITUDES`
+ * are recorded in the last bucket. Defaults to about 18 minutes.
+ */
+#ifndef NANORESOURCE_HISTOGRAM_MAGNITUDES
+#define NANORESOURCE_HISTOGRAM_MAGNITUDES 40
+#endif
+
+/**
+ * The number of buckets in a `struct nanoresource_histogram_s`.
+ */
+#define NANORESOURCE_HISTOGRAM_BUCKETS (                                   \
+  (NANORESOURCE_HISTOGRAM_MAGNITUDES - NANORESOURCE_HISTOGRAM_SUB_BUCKET_BITS \
+    + 1) << NANORESOURCE_HISTOGRAM_SUB_BUCKET_BITS)
+
+/**
+ * The number of request types (open, close, destroy, user) with histograms.
+ */
+#define NANORESOURCE_HISTOGRAM_TYPES (NANORESOURCE_REQUEST_USER + 1)
+
+/**
+ * The request lifecycle phase a latency histogram measures.
+ */
+enum nanoresource_histogram_phase {
+  // time from `nanoresource_queue_push()` to `nanoresource_request_run()`
+  NANORESOURCE_HISTOGRAM_QUEUED = 0,
+  // time from `nanoresource_request_run()` to `nanoresource_request_callback()`
+  NANORESOURCE_HISTOGRAM_RUNNING = 1,
+  NANORESOURCE_HISTOGRAM_PHASES = 2
+};
+
+/**
+ * A fixed memory log-linear (HDR style) histogram of nanosecond values.
+ */
+struct nanoresource_histogram_s {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t min;
+  uint64_t max;
+  uint32_t buckets[NANORESOURCE_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * Per resource latency histograms for each request type and phase. Only
+ * embedded in `struct nanoresource_s` when the library and its consumers are
+ * compiled with `NANORESOURCE_HISTOGRAMS` defined (`./configure --histograms`).
+ */
+struct nanoresource_histograms_s {
+  struct nanoresource_histogram_s
+    histograms[NANORESOURCE_HISTOGRAM_TYPES][NANORESOURCE_HISTOGRAM_PHASES];
+};
+
+#ifdef NANORESOURCE_HISTOGRAMS
+#define NANORESOURCE_HISTOGRAMS_FIELDS \
+  struct nanoresource_histograms_s histograms;
+#else
+#define NANORESOURCE_HISTOGRAMS_FIELDS
+#endif
+
+/**
+ * Resets a histogram to an empty state.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_histogram_reset(struct nanoresource_histogram_s *histogram);
+
+/**
+ * Records a value (in nanoseconds) in a histogram.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_histogram_record(
+  struct nanoresource_histogram_s *histogram,
+  uint64_t value);
+
+/**
+ * Merges the `source` histogram into the `target` histogram.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_histogram_merge(
+  struct nanoresource_histogram_s *target,
+  const struct nanoresource_histogram_s *source);
+
+/**
+ * Returns the highest value equivalent to the `percentile` (between `0`
+ * and `100`) of the values recorded in a histogram, or `0` if empty.
+ */
+NANORESOURCE_EXPORT uint64_t
+nanoresource_histogram_percentile(
+  const struct nanoresource_histogram_s *histogram,
+  double percentile);
+
+/**
+ * Copies the latency histogram of a resource for a request type and phase
+ * into `snapshot`. Returns `0` on success, otherwise an error code found in
+ * `errno.h` with its sign flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The resource or snapshot is `NULL`
+ *   * `EINVAL`: The request type or phase is out of range
+ *   * `ENOSYS`: The library was compiled without `NANORESOURCE_HISTOGRAMS`
+ */
+NANORESOURCE_EXPORT int
+nanoresource_histogram_snapshot(
+  struct nanoresource_s *resource,
+  enum nanoresource_request_type type,
+  enum nanoresource_histogram_phase phase,
+  struct nanoresource_histogram_s *snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
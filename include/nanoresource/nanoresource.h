@@ -2,17 +2,46 @@
 #define NANORESOURCE_H
 
 #include "allocator.h"
+#include "clock.h"
+#include "epoch.h"
+#include "file.h"
+#include "handle.h"
+#include "histogram.h"
+#include "observer.h"
+#include "pipeline.h"
+#include "pool.h"
 #include "resource.h"
 #include "platform.h"
 #include "request.h"
+#include "scheduler.h"
+#include "specialize.h"
+#include "timer.h"
+#include "trace.h"
 #include "version.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct nanoresource_s nanoresource_t;
 typedef struct nanoresource_options_s nanoresource_options_t;
+typedef struct nanoresource_retry_options_s nanoresource_retry_options_t;
+typedef struct nanoresource_timer_s nanoresource_timer_t;
+typedef struct nanoresource_file_s nanoresource_file_t;
+typedef struct nanoresource_handles_s nanoresource_handles_t;
+typedef struct nanoresource_event_s nanoresource_event_t;
+typedef struct nanoresource_observer_s nanoresource_observer_t;
+typedef struct nanoresource_histogram_s nanoresource_histogram_t;
+typedef enum nanoresource_histogram_phase nanoresource_histogram_phase_t;
+typedef struct nanoresource_trace_event_s nanoresource_trace_event_t;
 
 typedef struct nanoresource_request_s nanoresource_request_t;
 typedef struct nanoresource_request_options_s nanoresource_request_options_t;
 typedef struct nanoresource_allocator_stats_s nanoresource_allocator_stats_t;
 typedef enum nanoresource_request_type nanoresource_request_type_t;
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,461 @@
+#ifndef NANORESOURCE_HPP
+#define NANORESOURCE_HPP
+
+#include "nanoresource.h"
+#include <cerrno>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Header only C++17 bindings for libnanoresource. Everything in this file
+ * is inline templates over the C API; no extra allocations are made beyond
+ * the ones the C API already makes (one per resource and one per request).
+ */
+namespace nanoresource {
+
+/**
+ * A non-owning typed view of a `struct nanoresource_request_s` given to
+ * resource implementations and user request work functions.
+ */
+class request {
+  public:
+    explicit request(nanoresource_request_s *handle) noexcept
+      : handle_(handle) {}
+
+    /**
+     * Completes the request with an optional error code.
+     */
+    void
+    done(int err = 0) const noexcept {
+      handle_->callback(handle_, static_cast<unsigned int>(err));
+    }
+
+    nanoresource_request_type
+    type() const noexcept {
+      return handle_->type;
+    }
+
+    nanoresource_s *
+    resource() const noexcept {
+      return handle_->resource;
+    }
+
+    nanoresource_request_s *
+    get() const noexcept {
+      return handle_;
+    }
+
+  private:
+    nanoresource_request_s *handle_;
+};
+
+namespace detail {
+
+template <typename T, typename = void>
+struct has_open : std::false_type {};
+
+template <typename T>
+struct has_open<T, std::void_t<decltype(
+  std::declval<T &>().open(std::declval<request>()))>> : std::true_type {};
+
+template <typename T, typename = void>
+struct has_close : std::false_type {};
+
+template <typename T>
+struct has_close<T, std::void_t<decltype(
+  std::declval<T &>().close(std::declval<request>()))>> : std::true_type {};
+
+template <typename T, typename = void>
+struct has_destroy : std::false_type {};
+
+template <typename T>
+struct has_destroy<T, std::void_t<decltype(
+  std::declval<T &>().destroy(std::declval<request>()))>> : std::true_type {};
+
+/**
+ * A request allocated with its callback state inline. The memory is not
+ * the library's to free (`request.alloc == 0`), `after()` frees it once
+ * the callable state is destroyed as the library does not touch the
+ * request afterwards.
+ */
+template <typename Work, typename Done>
+struct operation {
+  nanoresource_request_s request;
+  Work work;
+  Done done;
+
+  operation(Work &&w, Done &&d)
+    : request(), work(std::move(w)), done(std::move(d)) {}
+
+  static operation *
+  create(
+    nanoresource_s *resource,
+    nanoresource_request_type type,
+    Work &&work,
+    Done &&done
+  ) noexcept {
+    void *memory = nanoresource_allocator_alloc(sizeof(operation));
+
+    if (nullptr == memory) {
+      return nullptr;
+    }
+
+    auto *self = ::new (memory) operation(std::move(work), std::move(done));
+    nanoresource_request_options_s options = {};
+
+    options.type = type;
+    options.resource = resource;
+    options.user = NANORESOURCE_REQUEST_USER == type ? run : nullptr;
+    options.after = after;
+    options.data = self;
+
+    nanoresource_request_init(&self->request, options);
+    return self;
+  }
+
+  static void
+  discard(operation *self) noexcept {
+    self->~operation();
+    nanoresource_allocator_free(self);
+  }
+
+  static void
+  run(nanoresource_request_s *handle) {
+    static_cast<operation *>(handle->data)->work(::nanoresource::request(handle));
+  }
+
+  static int
+  after(nanoresource_request_s *handle, unsigned int err) {
+    auto *self = static_cast<operation *>(handle->data);
+    self->done(static_cast<int>(err));
+    discard(self);
+    return 0;
+  }
+};
+
+// default completion callback
+struct noop {
+  void operator()(int) const noexcept {}
+};
+
+// default lifecycle operation, completes immediately
+struct complete {
+  void operator()(request r) const noexcept { r.done(0); }
+};
+
+template <typename Open, typename Close, typename Destroy>
+struct lambdas {
+  Open on_open;
+  Close on_close;
+  Destroy on_destroy;
+
+  void open(request r) { on_open(r); }
+  void close(request r) { on_close(r); }
+  void destroy(request r) { on_destroy(r); }
+};
+
+} // namespace detail
+
+/**
+ * A move-only owner of a `struct nanoresource_s` whose open, close, and
+ * destroy operations are the `open(request)`, `close(request)`, and
+ * `destroy(request)` member functions of `Impl` (each optional). The
+ * resource is destroyed with `nanoresource_destroy()` when the owner goes
+ * out of scope, and `Impl` is destroyed once the destroy request completes.
+ * The destroy request is stored with the resource, so destroying it never
+ * fails to allocate.
+ */
+template <typename Impl>
+class resource {
+  private:
+    struct state {
+      nanoresource_s handle;
+      nanoresource_request_s destroy;
+      Impl impl;
+
+      template <typename... Args>
+      explicit state(Args &&...args)
+        : handle(), destroy(), impl(std::forward<Args>(args)...) {}
+    };
+
+    static state *
+    self(nanoresource_s *handle) noexcept {
+      return static_cast<state *>(handle->data);
+    }
+
+    static void
+    on_open(nanoresource_request_s *handle) {
+      if constexpr (detail::has_open<Impl>::value) {
+        self(handle->resource)->impl.open(request(handle));
+      }
+    }
+
+    static void
+    on_close(nanoresource_request_s *handle) {
+      if constexpr (detail::has_close<Impl>::value) {
+        self(handle->resource)->impl.close(request(handle));
+      }
+    }
+
+    static void
+    on_destroy(nanoresource_request_s *handle) {
+      if constexpr (detail::has_destroy<Impl>::value) {
+        self(handle->resource)->impl.destroy(request(handle));
+      }
+    }
+
+    // the destroy request owns the state, the library does not touch the
+    // request or the resource once this returns
+    static int
+    on_destroyed(nanoresource_request_s *handle, unsigned int) {
+      state *memory = self(handle->resource);
+      nanoresource_free(&memory->handle);
+      memory->~state();
+      nanoresource_allocator_free(memory);
+      return 0;
+    }
+
+    // frees the state of a resource nothing refers to anymore
+    void
+    discard() noexcept {
+      state *memory = std::exchange(state_, nullptr);
+      nanoresource_free(&memory->handle);
+      memory->~state();
+      nanoresource_allocator_free(memory);
+    }
+
+    state *state_ = nullptr;
+
+  public:
+    /**
+     * Allocates and initializes a resource, forwarding `args` to the
+     * constructor of `Impl`. The `open`, `close`, `destroy`, and `data`
+     * fields of `options` are owned by the wrapper and overwritten.
+     * Check for allocation errors with `operator bool()`.
+     */
+    template <typename... Args>
+    explicit resource(nanoresource_options_s options, Args &&...args) noexcept {
+      void *memory = nanoresource_allocator_alloc(sizeof(state));
+
+      if (nullptr == memory) {
+        return;
+      }
+
+      state_ = ::new (memory) state(std::forward<Args>(args)...);
+
+      options.open = detail::has_open<Impl>::value ? on_open : nullptr;
+      options.close = detail::has_close<Impl>::value ? on_close : nullptr;
+      options.destroy = detail::has_destroy<Impl>::value ? on_destroy : nullptr;
+      options.data = state_;
+
+      nanoresource_init(&state_->handle, options);
+    }
+
+    resource() noexcept : resource(nanoresource_options_s {}) {}
+
+    resource(const resource &) = delete;
+    resource &operator=(const resource &) = delete;
+
+    resource(resource &&other) noexcept
+      : state_(std::exchange(other.state_, nullptr)) {}
+
+    resource &
+    operator=(resource &&other) noexcept {
+      if (this != &other) {
+        reset();
+        state_ = std::exchange(other.state_, nullptr);
+      }
+
+      return *this;
+    }
+
+    ~resource() {
+      if (reset() >= 0 || nullptr == state_) {
+        return;
+      }
+
+      // a resource going out of scope is not held back by backpressure,
+      // the destroy waits behind the requests queued before it
+      state_->handle.options.highwater = 0;
+
+      // otherwise the queue is full or the close could not be allocated,
+      // which leaves nothing to wait for when nothing is queued
+      if (
+        reset() < 0 &&
+        nullptr != state_ &&
+        0 == state_->handle.queued &&
+        0 == state_->handle.pending
+      ) {
+        discard();
+      }
+    }
+
+    /**
+     * Issues a destroy request for the owned resource (if any) and
+     * releases ownership. Ownership is kept when the destroy request could
+     * not be queued (ie: `EAGAIN` at the high watermark) so it can be
+     * retried.
+     */
+    int
+    reset() noexcept {
+      if (nullptr == state_) {
+        return 0;
+      }
+
+      nanoresource_s *handle = &state_->handle;
+      nanoresource_request_s *request = &state_->destroy;
+      nanoresource_request_options_s options = {};
+
+      // mirrors `nanoresource_destroy()` with the destroy request stored in
+      // the state, which it frees once it completes
+      int err = nanoresource_close(handle, nullptr);
+
+      if (err < 0) {
+        return err;
+      }
+
+      options.type = NANORESOURCE_REQUEST_DESTROY;
+      options.resource = handle;
+      options.after = on_destroyed;
+
+      nanoresource_request_init(request, options);
+
+      if ((err = nanoresource_queue_push(handle, request)) < 0) {
+        return err;
+      }
+
+      state_ = nullptr;
+
+      if (1 == nanoresource_request_runnable(request)) {
+        return -nanoresource_request_run(request);
+      }
+
+      return 0;
+    }
+
+    explicit operator bool() const noexcept {
+      return nullptr != state_;
+    }
+
+    nanoresource_s *
+    get() const noexcept {
+      return nullptr != state_ ? &state_->handle : nullptr;
+    }
+
+    Impl &
+    impl() const noexcept {
+      return state_->impl;
+    }
+
+    /**
+     * Opens the resource calling `done(int err)` when complete.
+     */
+    template <typename Done = detail::noop>
+    int
+    open(Done done = Done()) noexcept {
+      return submit(NANORESOURCE_REQUEST_OPEN, detail::complete(), std::move(done));
+    }
+
+    /**
+     * Closes the resource calling `done(int err)` when complete.
+     */
+    template <typename Done = detail::noop>
+    int
+    close(Done done = Done()) noexcept {
+      return submit(NANORESOURCE_REQUEST_CLOSE, detail::complete(), std::move(done));
+    }
+
+    /**
+     * Queues user work `work(request)` on the resource calling
+     * `done(int err)` after the work calls `request::done()`.
+     */
+    template <typename Work, typename Done = detail::noop>
+    int
+    run(Work work, Done done = Done()) noexcept {
+      return submit(NANORESOURCE_REQUEST_USER, std::move(work), std::move(done));
+    }
+
+    int
+    active() const noexcept {
+      return nanoresource_active(get());
+    }
+
+    int
+    inactive() const noexcept {
+      return nanoresource_inactive(get());
+    }
+
+  private:
+    template <typename Work, typename Done>
+    int
+    submit(nanoresource_request_type type, Work &&work, Done &&done) noexcept {
+      using operation = detail::operation<
+        std::decay_t<Work>,
+        std::decay_t<Done>>;
+
+      if (nullptr == state_) {
+        return -EFAULT;
+      }
+
+      auto *op = operation::create(
+        &state_->handle, type, std::move(work), std::move(done));
+
+      if (nullptr == op) {
+        return -ENOMEM;
+      }
+
+      if (nanoresource_queue_push(&state_->handle, &op->request) < 0) {
+        int err = -errno;
+        operation::discard(op);
+        return err;
+      }
+
+      // mirrors `nanoresource_submit()` with the state machine specialized
+      // for `Impl` so its operations are called directly
+      if (1 == nanoresource_request_runnable(&op->request)) {
+        int result = 0;
+
+        if (0 == nanoresource_request_begin(&op->request, &result)) {
+          return -result;
+        }
+
+        return -nanoresource_request_dispatch(
+          &op->request,
+          detail::has_open<Impl>::value ? on_open : nullptr,
+          detail::has_close<Impl>::value ? on_close : nullptr,
+          detail::has_destroy<Impl>::value ? on_destroy : nullptr,
+          NANORESOURCE_REQUEST_USER == type ? operation::run : nullptr);
+      }
+
+      return -static_cast<int>(op->request.err);
+    }
+};
+
+/**
+ * Creates a resource from `open`, `close`, and `destroy` callables taking
+ * a `nanoresource::request`.
+ */
+template <
+  typename Open = detail::complete,
+  typename Close = detail::complete,
+  typename Destroy = detail::complete>
+resource<detail::lambdas<Open, Close, Destroy>>
+make_resource(
+  Open open = Open(),
+  Close close = Close(),
+  Destroy destroy = Destroy(),
+  nanoresource_options_s options = {}
+) noexcept {
+  return resource<detail::lambdas<Open, Close, Destroy>>(
+    options,
+    detail::lambdas<Open, Close, Destroy> {
+      std::move(open),
+      std::move(close),
+      std::move(destroy)
+    });
+}
+
+} // namespace nanoresource
+
+#endif
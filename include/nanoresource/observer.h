@@ -0,0 +1,112 @@
+#ifndef NANORESOURCE_OBSERVER_H
+#define NANORESOURCE_OBSERVER_H
+
+#include "platform.h"
+#include "request.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+struct nanoresource_s;
+struct nanoresource_event_s;
+struct nanoresource_observer_s;
+
+/**
+ * The `nanoresource_observer_callback_t` callback represents the user
+ * callback for a resource state transition event.
+ */
+typedef void (nanoresource_observer_callback_t)(
+  struct nanoresource_observer_s *observer,
+  const struct nanoresource_event_s *event);
+
+/**
+ * Represents a resource state transition. The `type` is the type of the
+ * lifecycle request that caused the transition (open, close, or destroy)
+ * and `err` is non-zero when the request failed and the state did not
+ * change. The `timestamp` is taken with `nanoresource_clock_now()`.
+ */
+struct nanoresource_event_s {
+  enum nanoresource_request_type type;
+  unsigned int err;
+  uint64_t timestamp;
+  struct nanoresource_s *resource;
+  struct nanoresource_request_s *request;
+};
+
+/**
+ * Fields for `struct nanoresource_observer_s` that can be used for
+ * extending structures that ensure correct memory layout.
+ */
+#define NANORESOURCE_OBSERVER_FIELDS           \
+  nanoresource_observer_callback_t *callback;  \
+  struct nanoresource_observer_s *next;        \
+  struct nanoresource_observer_s **attached;   \
+  void *data;
+
+/**
+ * Represents an observer of resource state transitions. Observers are
+ * intrusive and owned by the caller, and can only be attached to one
+ * observer list (global or per resource) at a time, the list is kept in
+ * `attached`. Observers of a resource are detached when it is freed.
+ */
+struct nanoresource_observer_s {
+  NANORESOURCE_OBSERVER_FIELDS
+};
+
+/**
+ * Initializes a pointer to `struct nanoresource_observer_s` with a callback
+ * and user data. Returns `0` on success, otherwise an error code found in
+ * `errno.h` with its sign flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_observer_s *observer' is `NULL`
+ */
+NANORESOURCE_EXPORT int
+nanoresource_observer_init(
+  struct nanoresource_observer_s *observer,
+  nanoresource_observer_callback_t *callback,
+  void *data);
+
+/**
+ * Attaches an observer to the global observer list. Global observers
+ * receive events for every resource. Returns `0` on success, otherwise an
+ * error code found in `errno.h` with its sign flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_observer_s *observer' is `NULL`
+ *   * `EEXIST`: The observer is already attached to an observer list
+ */
+NANORESOURCE_EXPORT int
+nanoresource_observe(struct nanoresource_observer_s *observer);
+
+/**
+ * Detaches an observer from the global observer list.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_unobserve(struct nanoresource_observer_s *observer);
+
+/**
+ * Attaches an observer to the observer list of a resource. Resource
+ * observers are called before global observers.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_resource_observe(
+  struct nanoresource_s *resource,
+  struct nanoresource_observer_s *observer);
+
+/**
+ * Detaches an observer from the observer list of a resource.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_resource_unobserve(
+  struct nanoresource_s *resource,
+  struct nanoresource_observer_s *observer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
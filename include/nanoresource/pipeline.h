@@ -0,0 +1,54 @@
+#ifndef NANORESOURCE_PIPELINE_H
+#define NANORESOURCE_PIPELINE_H
+
+#include "platform.h"
+#include "request.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+struct nanoresource_s;
+
+/**
+ * The `nanoresource_pipeline_callback_t` callback represents the user
+ * callback called once every step of a pipeline completed, with the error
+ * of a step that failed, if any.
+ */
+typedef void (nanoresource_pipeline_callback_t)(
+  struct nanoresource_s *resource,
+  int err,
+  void *data);
+
+/**
+ * Queues an open request, a user request for each of the `count` work
+ * functions in `steps` (called with `request->data` set to `data`), and a
+ * close request on the resource as one unit. The steps run back to back
+ * as each one completes, without per step allocations or callbacks (the
+ * requests are stored contiguously in a single allocation), and
+ * `callback(resource, err, data)` is called once the close request
+ * completes. If the open request fails the remaining steps fail with its
+ * error. Returns `0` on success, otherwise an error code found in
+ * `errno.h` with its sign flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The resource or steps are `NULL`, or the pipeline could
+ *     not be allocated
+ *   * `EAGAIN`: The resource queue can not fit every step, nothing was
+ *     queued
+ *   * `ENOSYS`: The library was compiled with `NANORESOURCE_STATIC_POOLS`
+ */
+NANORESOURCE_EXPORT int
+nanoresource_pipeline(
+  struct nanoresource_s *resource,
+  nanoresource_request_work_callback_t *const *steps,
+  unsigned int count,
+  nanoresource_pipeline_callback_t *callback,
+  void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,6 +3,7 @@
 
 #if defined(_WIN32)
 #  define NANORESOURCE_EXPORT __declspec(dllimport)
+#  define NANORESOURCE_INLINE __inline
 #elif defined(__GNUC__) && (__GNUC__ * 100 + __GNUC_MINOR) >= 303
 #  define NANORESOURCE_EXPORT __attribute__((visibility("default")))
 #  define NANORESOURCE_INLINE inline
@@ -11,10 +12,37 @@
 #  define NANORESOURCE_INLINE
 #endif
 
+/**
+ * Linkage of the hot path functions (the request queue, active state, and
+ * request state machine). They are exported from the library, or defined
+ * `static inline` in every translation unit including the single header
+ * amalgamation (see `scripts/amalgamate`) so they can be inlined into the
+ * caller without link time optimization.
+ */
+#ifdef NANORESOURCE_AMALGAMATION
+#  define NANORESOURCE_HOT static NANORESOURCE_INLINE
+#else
+#  define NANORESOURCE_HOT NANORESOURCE_EXPORT
+#endif
+
+#if defined(_MSC_VER)
+#  define NANORESOURCE_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#  define NANORESOURCE_THREAD_LOCAL __thread
+#else
+#  define NANORESOURCE_THREAD_LOCAL
+#endif
+
 #ifndef NANORESOURCE_ALIGNMENT
 #  define NANORESOURCE_ALIGNMENT sizeof(unsigned long) // platform word
 #endif
 
+/**
+ * Fails compilation when `expr` is false, used for structure size budgets.
+ */
+#define NANORESOURCE_STATIC_ASSERT(expr, name) \
+  typedef char nanoresource_static_assert_##name[(expr) ? 1 : -1]
+
 #ifndef NANORESOURCE_MAX_ENUM
 #  define NANORESOURCE_MAX_ENUM 0x7FFFFFFF
 #endif
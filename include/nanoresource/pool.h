@@ -0,0 +1,64 @@
+#ifndef NANORESOURCE_POOL_H
+#define NANORESOURCE_POOL_H
+
+#include "platform.h"
+#include <errno.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+struct nanoresource_pool_stats_s;
+
+/**
+ * The capacity of the resource pool when compiled with
+ * `NANORESOURCE_STATIC_POOLS`, where resources and requests allocated by
+ * the library come from fixed capacity pools reserved with the program
+ * instead of `nanoresource_allocator_alloc()`. `nanoresource_file_read()`
+ * and `nanoresource_pipeline()`, which allocate blocks of their own, fail
+ * with `ENOSYS` then.
+ */
+#ifndef NANORESOURCE_MAX_RESOURCES
+#define NANORESOURCE_MAX_RESOURCES 64
+#endif
+
+/**
+ * The capacity of the request pool when compiled with
+ * `NANORESOURCE_STATIC_POOLS`.
+ */
+#ifndef NANORESOURCE_MAX_REQUESTS
+#define NANORESOURCE_MAX_REQUESTS 1024
+#endif
+
+/**
+ * The error code for a request that could not be allocated. Requests go
+ * back to the pool as they complete, so an exhausted pool is transient.
+ */
+#ifdef NANORESOURCE_STATIC_POOLS
+#define NANORESOURCE_REQUEST_ALLOC_ERROR EAGAIN
+#else
+#define NANORESOURCE_REQUEST_ALLOC_ERROR EFAULT
+#endif
+
+/**
+ * The number of resources and requests allocated by the library and not
+ * freed yet.
+ */
+struct nanoresource_pool_stats_s {
+  unsigned int resources;
+  unsigned int requests;
+};
+
+/**
+ * Returns pool stats, also counted when the library is not compiled with
+ * `NANORESOURCE_STATIC_POOLS` so pools can be sized from a regular build.
+ */
+NANORESOURCE_EXPORT const struct nanoresource_pool_stats_s
+nanoresource_pool_stats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,11 +1,18 @@
 #ifndef NANORESOURCE_REQUEST_H
 #define NANORESOURCE_REQUEST_H
 
+#include "epoch.h"
 #include "platform.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 // Forward declarations
 struct nanoresource_request_s;
 struct nanoresource_request_options_s;
+struct nanoresource_request_inline_s;
 
 /**
  * The `nanoresource_request_result_callback_t` callback represents the user
@@ -22,6 +29,15 @@ typedef int (nanoresource_request_result_callback_t)(
 typedef void (nanoresource_request_work_callback_t)(
   struct nanoresource_request_s *request);
 
+/**
+ * The `nanoresource_request_complete_callback_t` callback represents the
+ * user callback for a completed request, called with the request (and its
+ * inline payload) right after the `(resource, err)` callback.
+ */
+typedef void (nanoresource_request_complete_callback_t)(
+  struct nanoresource_request_s *request,
+  int err);
+
 /**
  */
 enum nanoresource_request_type {
@@ -32,9 +48,31 @@ enum nanoresource_request_type {
   NANORESOURCE_REQUEST_NONE = NANORESOURCE_MAX_ENUM
 };
 
+/**
+ * The highest request priority, see `NANORESOURCE_QUEUE_PRIORITY`.
+ */
+#define NANORESOURCE_REQUEST_MAX_PRIORITY 255
+
+/**
+ * The size in bytes of the payload buffer stored inline in every request
+ * for per call context, see `nanoresource_request_payload()`. Set it to
+ * `0` to leave the buffer out (`./configure --request-payload-size=0`).
+ * It changes the layout of `struct nanoresource_request_s` and
+ * `struct nanoresource_s`, so the library and its consumers must be
+ * compiled with the same value.
+ */
+#ifndef NANORESOURCE_REQUEST_PAYLOAD_SIZE
+#define NANORESOURCE_REQUEST_PAYLOAD_SIZE 48
+#endif
+
 /**
  * Fields for `struct nanoresource_request_options_s` that can be used for
- * extending structures that ensure correct memory layout.
+ * extending structures that ensure correct memory layout. The `priority`
+ * (higher first, up to `NANORESOURCE_REQUEST_MAX_PRIORITY`) and `deadline`
+ * (a `nanoresource_clock_now()` timestamp, `0` for none) of user requests
+ * are used by the queue discipline of the resource. The `payload_size`
+ * bytes at `payload` (at most `NANORESOURCE_REQUEST_PAYLOAD_SIZE`) are
+ * copied into the inline payload of the request.
  */
 #define NANORESOURCE_REQUEST_OPTIONS_FIELDS        \
   enum nanoresource_request_type type;             \
@@ -43,7 +81,12 @@ enum nanoresource_request_type {
   nanoresource_request_result_callback_t *after;   \
   struct nanoresource_s *resource;                 \
   void *callback;                                  \
-  void *data;
+  void *data;                                      \
+  unsigned int priority;                           \
+  uint64_t deadline;                               \
+  nanoresource_request_complete_callback_t *complete; \
+  const void *payload;                             \
+  unsigned int payload_size;
 
 /**
  * Represents the initial configurable state for a resource
@@ -53,6 +96,33 @@ struct nanoresource_request_options_s {
   NANORESOURCE_REQUEST_OPTIONS_FIELDS
 };
 
+/**
+ * Timestamps for latency histograms, only present when compiled with
+ * `NANORESOURCE_HISTOGRAMS` defined.
+ */
+#ifdef NANORESOURCE_HISTOGRAMS
+#define NANORESOURCE_REQUEST_TIMESTAMP_FIELDS       \
+  uint64_t queued_at;                               \
+  uint64_t started_at;
+#else
+#define NANORESOURCE_REQUEST_TIMESTAMP_FIELDS
+#endif
+
+/**
+ * The inline payload buffer of a request, aligned for any scalar type.
+ */
+#if NANORESOURCE_REQUEST_PAYLOAD_SIZE > 0
+#define NANORESOURCE_REQUEST_PAYLOAD_FIELDS         \
+  union {                                           \
+    unsigned char bytes[NANORESOURCE_REQUEST_PAYLOAD_SIZE]; \
+    uint64_t u64;                                   \
+    double f64;                                     \
+    void *pointer;                                  \
+  } payload;
+#else
+#define NANORESOURCE_REQUEST_PAYLOAD_FIELDS
+#endif
+
 /**
  * Fields for `struct nanoresource_request_s` that can be used for
  * extending structures that ensure correct memory layout.
@@ -61,6 +131,9 @@ struct nanoresource_request_options_s {
   unsigned int alloc:1;                             \
   unsigned int err;                                 \
   unsigned int pending:1;                           \
+  unsigned int exclusive:1;                         \
+  unsigned int running:1;                           \
+  unsigned int priority:8;                          \
   enum nanoresource_request_type type;              \
   nanoresource_request_work_callback_t *user;       \
   nanoresource_request_result_callback_t *before;   \
@@ -68,7 +141,23 @@ struct nanoresource_request_options_s {
   nanoresource_request_result_callback_t *after;    \
   struct nanoresource_s *resource;                  \
   void *done;                                       \
-  void *data;
+  void *data;                                       \
+  uint64_t deadline;                                \
+  nanoresource_request_complete_callback_t *complete; \
+  struct nanoresource_request_inline_s *inlined;    \
+  NANORESOURCE_REQUEST_TIMESTAMP_FIELDS             \
+  NANORESOURCE_EPOCH_FIELDS                         \
+  NANORESOURCE_REQUEST_PAYLOAD_FIELDS
+
+/**
+ * The size budget in bytes of `struct nanoresource_request_s` including the
+ * inline payload and excluding the epoch node, checked at compile time so
+ * layout regressions are caught. A larger
+ * `NANORESOURCE_REQUEST_PAYLOAD_SIZE` needs a larger budget.
+ */
+#ifndef NANORESOURCE_REQUEST_SIZE_BUDGET
+#define NANORESOURCE_REQUEST_SIZE_BUDGET 160
+#endif
 
 /**
  * Represents the state for a resource operation context.
@@ -80,7 +169,9 @@ struct nanoresource_request_s {
 /**
  * Allocates a pointer to 'struct nanoresource_request_s'.
  * Calls 'nanoresource_alloc()' internally and will return 'NULL'
- * on allocation errors.
+ * on allocation errors. Takes it from the request pool instead when
+ * compiled with `NANORESOURCE_STATIC_POOLS`, returning 'NULL' with
+ * `errno` set to `EAGAIN` when the pool is exhausted.
  */
 NANORESOURCE_EXPORT struct nanoresource_request_s *
 nanoresource_request_alloc();
@@ -92,6 +183,7 @@ nanoresource_request_alloc();
  *
  * Possible Error Codes
  *   * `EFAULT`: The 'struct nanoresource_request_s *request' is `NULL`
+ *   * `EINVAL`: The resource is `NULL` or the payload does not fit
  */
 NANORESOURCE_EXPORT int
 nanoresource_request_init(
@@ -106,6 +198,19 @@ nanoresource_request_init(
 NANORESOURCE_EXPORT struct nanoresource_request_s *
 nanoresource_request_new(const struct nanoresource_request_options_s options);
 
+/**
+ * Returns a pointer to the inline payload of a request, valid until the
+ * request is freed, or `NULL` if `NANORESOURCE_REQUEST_PAYLOAD_SIZE` is `0`.
+ */
+static NANORESOURCE_INLINE void *
+nanoresource_request_payload(struct nanoresource_request_s *request) {
+#if NANORESOURCE_REQUEST_PAYLOAD_SIZE > 0
+  return request->payload.bytes;
+#else
+  return 0;
+#endif
+}
+
 /**
  * Frees a pointer to `struct nanoresource_request_s`.
  */
@@ -115,16 +220,30 @@ nanoresource_request_free(struct nanoresource_request_s *request);
 /**
  * Runs the request for a resourceoperation.
  */
-NANORESOURCE_EXPORT int
+NANORESOURCE_HOT int
 nanoresource_request_run(struct nanoresource_request_s *request);
 
+/**
+ * Returns `1` if a request just pushed to the end of the queue of its
+ * resource can run right away, otherwise `0`. Requests run right away when
+ * nothing else is running, and user requests also when they only queue
+ * behind running user requests and the `max_inflight` option of the
+ * resource allows another one.
+ */
+NANORESOURCE_HOT int
+nanoresource_request_runnable(struct nanoresource_request_s *request);
+
 /**
  * Handles the callback from the resource operation
  * request function given to the implementation.
  */
-NANORESOURCE_EXPORT int
+NANORESOURCE_HOT int
 nanoresource_request_callback(
   struct nanoresource_request_s *request,
   unsigned int err);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
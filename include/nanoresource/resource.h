@@ -1,13 +1,22 @@
 #ifndef NANORESOURCE_RESOURCE_H
 #define NANORESOURCE_RESOURCE_H
 
+#include "epoch.h"
+#include "histogram.h"
 #include "platform.h"
 #include "request.h"
+#include "timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 // Forward declarations
 struct nanoresource_s;
 struct nanoresource_options_s;
+struct nanoresource_retry_options_s;
 struct nanoresource_request_s;
+struct nanoresource_observer_s;
 
 /**
  * The maximum queued requests.
@@ -16,6 +25,16 @@ struct nanoresource_request_s;
 #define NANORESOURCE_MAX_REQUEST_QUEUE 512
 #endif
 
+/**
+ * The size budget in bytes of `struct nanoresource_s` excluding the request
+ * queue, histograms, and epoch nodes, checked at compile time so layout regressions are
+ * caught. It includes the copy of the last request, so it is raised along
+ * with `NANORESOURCE_REQUEST_SIZE_BUDGET`.
+ */
+#ifndef NANORESOURCE_RESOURCE_SIZE_BUDGET
+#define NANORESOURCE_RESOURCE_SIZE_BUDGET 368
+#endif
+
 /**
  * The `nanoresource_open_callback_t` callback represents the user callback
  * for a resource operation open request.
@@ -53,12 +72,57 @@ typedef void (nanoresource_user_callback_t)(
   struct nanoresource_s *resource,
   int err);
 
+/**
+ * The `nanoresource_drain_callback_t` callback represents the user callback
+ * called when a throttled resource queue falls to its low watermark.
+ */
+typedef void (nanoresource_drain_callback_t)(
+  struct nanoresource_s *resource);
+
+/**
+ * The order user requests wait in the queue of a resource. Requests are
+ * first in first out by default. The `NANORESOURCE_QUEUE_PRIORITY`
+ * discipline runs user requests with a higher `priority` first, and the
+ * `NANORESOURCE_QUEUE_DEADLINE` discipline runs user requests with the
+ * earliest `deadline` first (requests without a deadline last). Requests
+ * with the same priority or deadline stay in order, and user requests never
+ * pass running requests or lifecycle (open, close, destroy) and exclusive
+ * requests queued before them.
+ */
+enum nanoresource_queue_discipline {
+  NANORESOURCE_QUEUE_FIFO = 0,
+  NANORESOURCE_QUEUE_PRIORITY = 1,
+  NANORESOURCE_QUEUE_DEADLINE = 2
+};
+
+/**
+ * Represents the retry policy for failed open requests. Retries are
+ * disabled when `attempts` is `0`. The delay before retry `n` is
+ * `delay * 2^n` milliseconds capped at `max_delay` (when not `0`), reduced
+ * by a random amount of up to `jitter` percent. Retries are driven by the
+ * shared timer list, see `nanoresource_timers_run()`.
+ */
+struct nanoresource_retry_options_s {
+  unsigned int attempts;
+  unsigned int jitter;
+  unsigned long int delay;
+  unsigned long int max_delay;
+};
+
 /**
  */
 #define NANORESOURCE_OPTIONS_FIELDS              \
   nanoresource_request_work_callback_t *open;    \
   nanoresource_request_work_callback_t *close;   \
   nanoresource_request_work_callback_t *destroy; \
+  nanoresource_drain_callback_t *drain;          \
+  unsigned int highwater;                        \
+  unsigned int lowwater;                         \
+  unsigned int max_inflight;                     \
+  enum nanoresource_queue_discipline discipline; \
+  unsigned int weight;                           \
+  unsigned int sync;                             \
+  struct nanoresource_retry_options_s retry;     \
   void *data;
 
 
@@ -70,6 +134,8 @@ typedef void (nanoresource_user_callback_t)(
   unsigned int queued;                                          \
   unsigned int pending;                                         \
   unsigned int actives;                                         \
+  unsigned int exclusives;                                      \
+  unsigned int inflight;                                        \
   unsigned int opened:1;                                        \
   unsigned int closed:1;                                        \
   unsigned int opening:1;                                       \
@@ -78,10 +144,24 @@ typedef void (nanoresource_user_callback_t)(
   unsigned int destroying:1;                                    \
   unsigned int needs_open:1;                                    \
   unsigned int fast_close:1;                                    \
+  unsigned int throttled:1;                                     \
+  unsigned int runnable:1;                                      \
+  unsigned int scheduled:1;                                     \
+  unsigned int reopening:1;                                     \
+  unsigned int deficit;                                         \
+  struct nanoresource_s *next_runnable;                         \
+  unsigned int retries;                                         \
+  unsigned int refs;                                            \
+  unsigned int retiring_refs;                                   \
+  void *retiring;                                               \
+  struct nanoresource_timer_s retry_timer;                          \
+  struct nanoresource_observer_s *observers;                        \
   struct nanoresource_request_s last_request;                       \
-  struct nanoresource_request_s *queue[NANORESOURCE_MAX_REQUEST_QUEUE]; \
   struct nanoresource_options_s options;                            \
   void *data;                                                   \
+  struct nanoresource_request_s *queue[NANORESOURCE_MAX_REQUEST_QUEUE]; \
+  NANORESOURCE_HISTOGRAMS_FIELDS                                    \
+  NANORESOURCE_EPOCH_FIELDS                                         \
 
 
 
@@ -97,6 +177,11 @@ struct nanoresource_s {
   NANORESOURCE_FIELDS
 };
 
+/**
+ * Allocates a pointer to `struct nanoresource_s`, taken from the resource
+ * pool when compiled with `NANORESOURCE_STATIC_POOLS`. Returns `NULL` with
+ * `errno` set to `ENOMEM` when the pool is exhausted.
+ */
 NANORESOURCE_EXPORT struct nanoresource_s *
 nanoresource_alloc();
 
@@ -138,30 +223,162 @@ nanoresource_destroy(
   struct nanoresource_s *resource,
   nanoresource_destroy_callback_t *callback);
 
+/**
+ * Opens a new generation of `resource->data` without closing the resource
+ * or waiting for its active users, ie: to rotate a log file or reload a
+ * configuration. `options.open` is called right away (outside the queue)
+ * with the current data in `request->data` and stores the new data there
+ * before completing the request. The new data is then published to
+ * `resource->data` with a release store, and the previous data is handed
+ * to `options.close` in `request->data` once the last user pinning it
+ * with `nanoresource_acquire()` releases it (right away if there are none,
+ * never if the data did not change). The resource counts as active until
+ * both complete, so close and destroy requests wait for them. Calls
+ * `callback(resource, err)` when the new data is published or the open
+ * failed, in which case the current data stays in use. Returns `0` on
+ * success, otherwise an error code found in `errno.h` with its sign
+ * flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_s *resource' is `NULL` or the
+ *     request could not be allocated
+ *   * `ENOLCK`: The resource is not opened
+ *   * `EAGAIN`: The resource is closing, or the request pool is exhausted
+ *     (with `NANORESOURCE_STATIC_POOLS`)
+ *   * `EBUSY`: The resource is reopening, a previous generation has not
+ *     been closed yet, or an exclusive request is waiting or running
+ */
+NANORESOURCE_EXPORT int
+nanoresource_reopen(
+  struct nanoresource_s *resource,
+  nanoresource_open_callback_t *callback);
+
 /**
  * Returns the head of the queue pointing to a `struct nanoresource_request_s`
  * type and shifts the remaining elements over to the left by 1.
  */
-NANORESOURCE_EXPORT struct nanoresource_request_s *
+NANORESOURCE_HOT struct nanoresource_request_s *
 nanoresource_queue_shift(struct nanoresource_s *resource);
 
+/**
+ * Removes a request from anywhere in the queue shifting the elements after
+ * it over to the left by 1. Returns the removed request, or `0` if the
+ * request is not in the queue.
+ */
+NANORESOURCE_HOT struct nanoresource_request_s *
+nanoresource_queue_remove(
+  struct nanoresource_s *resource,
+  struct nanoresource_request_s *request);
+
 /**
  * Pushes a `struct nanoresource_request_s` pointer on to the queue returning
- * the new queue length.
+ * the new queue length. Returns `-EAGAIN` and marks the resource as throttled
+ * when the queue length is at the high watermark (`options.highwater`,
+ * defaulting to `NANORESOURCE_MAX_REQUEST_QUEUE`). The `options.drain`
+ * callback is called once the queue falls to the low watermark
+ * (`options.lowwater`) again.
  */
-NANORESOURCE_EXPORT int
+NANORESOURCE_HOT int
 nanoresource_queue_push(
   struct nanoresource_s *resource,
   struct nanoresource_request_s *request);
 
 /**
+ * Queues a user request on the resource and runs it if the resource is idle.
+ * Resources initialized with the `sync` option, whose operations always
+ * complete requests before returning, run user requests submitted while
+ * they are opened and idle right away instead, without queueing them or
+ * copying them to `last_request`, and return their result. Returns `0` on
+ * success, otherwise an error code found in `errno.h` with its sign flipped
+ * and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The resource or request is `NULL`
+ *   * `EINVAL`: The request does not belong to the resource
+ *   * `EAGAIN`: The resource queue is at its high watermark
  */
-NANORESOURCE_EXPORT int
+NANORESOURCE_HOT int
+nanoresource_submit(
+  struct nanoresource_s *resource,
+  struct nanoresource_request_s *request);
+
+/**
+ * Marks the resource as actively used, see `nanoresource_active_shared()`.
+ */
+NANORESOURCE_HOT int
 nanoresource_active(struct nanoresource_s *resource);
 
 /**
+ * Marks the resource as actively used by a reader. Shared users overlap
+ * with each other and user requests, and hold back close, destroy, and
+ * exclusive requests until they are released with
+ * `nanoresource_inactive()`. Returns `0` on success, a positive error code
+ * if the resource can not be used right now, otherwise an error code found
+ * in `errno.h` with its sign flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_s *resource' is `NULL`
+ *   * `EAGAIN`: The resource is closing
+ *   * `ENOLCK`: The resource is closed
+ *   * `EBUSY`: An exclusive request is waiting or running
+ */
+NANORESOURCE_HOT int
+nanoresource_active_shared(struct nanoresource_s *resource);
+
+/**
+ * Queues an exclusive user request that calls `work(request)` once every
+ * shared user is released, without closing the resource. New shared users
+ * are refused with `EBUSY` from the moment the request is queued so
+ * waiting writers are not starved, and requests queued after it run once
+ * `work` completes the request with `request->callback(request, err)`,
+ * which then calls `callback(resource, err)`. Returns `0` on success,
+ * otherwise an error code found in `errno.h` with its sign flipped and
+ * `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_s *resource' is `NULL` or the
+ *     request could not be allocated
+ *   * `EAGAIN`: The resource queue is at its high watermark, or the request
+ *     pool is exhausted (with `NANORESOURCE_STATIC_POOLS`)
  */
 NANORESOURCE_EXPORT int
+nanoresource_active_exclusive(
+  struct nanoresource_s *resource,
+  nanoresource_request_work_callback_t *work,
+  nanoresource_user_callback_t *callback);
+
+/**
+ */
+NANORESOURCE_HOT int
 nanoresource_inactive(struct nanoresource_s *resource);
 
+/**
+ * Marks the resource as actively used like `nanoresource_active()` and
+ * pins the current generation of `resource->data`, stored in `data`, so it
+ * stays open through `nanoresource_reopen()` until it is released with
+ * `nanoresource_release()`. Returns `0` on success, a positive error code
+ * if the resource can not be used right now (see `nanoresource_active()`),
+ * otherwise an error code found in `errno.h` with its sign flipped and
+ * `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_s *resource' or `data` is `NULL`
+ */
+NANORESOURCE_EXPORT int
+nanoresource_acquire(struct nanoresource_s *resource, void **data);
+
+/**
+ * Releases a generation of `resource->data` pinned with
+ * `nanoresource_acquire()`, closing it if it was replaced and this was its
+ * last user, and marks the resource as inactive with
+ * `nanoresource_inactive()`. A replaced generation whose close request can
+ * not be allocated is kept and closed by a later release, reopen, or close.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_release(struct nanoresource_s *resource, void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
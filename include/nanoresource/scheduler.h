@@ -0,0 +1,52 @@
+#ifndef NANORESOURCE_SCHEDULER_H
+#define NANORESOURCE_SCHEDULER_H
+
+#include "platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+struct nanoresource_s;
+
+/**
+ * The number of requests a resource with a `weight` of `1` may start each
+ * round of the shared scheduler.
+ */
+#ifndef NANORESOURCE_SCHEDULER_QUANTUM
+#define NANORESOURCE_SCHEDULER_QUANTUM 1
+#endif
+
+/**
+ * Starts queued requests of resources with a non-zero `weight` option,
+ * visiting runnable resources in deficit round robin order so a resource
+ * with a deep queue can not starve the others. Each round a resource may
+ * start up to `weight * NANORESOURCE_SCHEDULER_QUANTUM` requests, one at a
+ * time, before it goes to the back of the runnable list. Idle resources are
+ * never visited. Returns the number of requests started, at most `budget`
+ * (`0` for no limit). Hosts should call this from their event loop or
+ * worker threads (serialized like every other call on a resource), see
+ * `nanoresource_scheduler_runnable()`.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_scheduler_run(unsigned int budget);
+
+/**
+ * Returns the number of resources waiting on the shared scheduler.
+ */
+NANORESOURCE_EXPORT unsigned int
+nanoresource_scheduler_runnable();
+
+/**
+ * Removes a resource from the runnable list of the shared scheduler. This
+ * is called by `nanoresource_free()`.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_scheduler_remove(struct nanoresource_s *resource);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef NANORESOURCE_SPECIALIZE_H
+#define NANORESOURCE_SPECIALIZE_H
+
+#include "allocator.h"
+#include "platform.h"
+#include "pool.h"
+#include "request.h"
+#include "resource.h"
+#include <errno.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Runs the bookkeeping of `nanoresource_request_run()` that happens before
+ * the request operation is dispatched. Returns `1` if the request should be
+ * dispatched with `nanoresource_request_dispatch()`, otherwise `0` with the
+ * return value of the run stored in `result`.
+ */
+NANORESOURCE_HOT int
+nanoresource_request_begin(
+  struct nanoresource_request_s *request,
+  int *result);
+
+/**
+ * The lifecycle state machine of `nanoresource_request_run()`, dispatching
+ * the request to the `open`, `close`, `destroy`, or `user` operation. A `0`
+ * operation completes the request right away, and a `0` user operation
+ * falls back to `request->user`. When the operations are compile time
+ * constants the compiler folds the checks and turns the indirect calls into
+ * direct (inlinable) ones, see `NANORESOURCE_SPECIALIZE()`.
+ */
+static NANORESOURCE_INLINE int
+nanoresource_request_dispatch(
+  struct nanoresource_request_s *request,
+  nanoresource_request_work_callback_t *open,
+  nanoresource_request_work_callback_t *close,
+  nanoresource_request_work_callback_t *destroy,
+  nanoresource_request_work_callback_t *user
+) {
+  struct nanoresource_s *resource = request->resource;
+
+  switch (request->type) {
+    case NANORESOURCE_REQUEST_OPEN:
+      if (1 == resource->opened && 0 == resource->needs_open) {
+        return nanoresource_request_callback(request, 0);
+      } else if (0 != open) {
+        resource->opening = 1;
+        open(request);
+      } else {
+        resource->opening = 1;
+        return nanoresource_request_callback(request, 0);
+      }
+      break;
+
+    case NANORESOURCE_REQUEST_CLOSE:
+      if (1 == resource->closed || 0 == resource->opened) {
+        return nanoresource_request_callback(request, 0);
+      } else if (0 != close) {
+        resource->closing = 1;
+        close(request);
+      } else {
+        resource->closing = 1;
+        return nanoresource_request_callback(request, 0);
+      }
+      break;
+
+    case NANORESOURCE_REQUEST_DESTROY:
+      if (1 == resource->destroyed) {
+        return nanoresource_request_callback(request, 0);
+      } else if (0 != destroy) {
+        destroy(request);
+      } else {
+        return nanoresource_request_callback(request, 0);
+      }
+      break;
+
+    case NANORESOURCE_REQUEST_USER:
+      if (0 != user) {
+        user(request);
+      } else if (0 != request->user) {
+        request->user(request);
+      } else {
+        return nanoresource_request_callback(request, 0);
+      }
+      break;
+
+    case NANORESOURCE_REQUEST_NONE:
+      return nanoresource_request_callback(request, ENOSYS);
+  }
+
+  return 0;
+}
+
+/**
+ * Returns `1` if a user request can skip the queue of a `sync` resource,
+ * which is when it is opened and nothing is queued or running on it (so
+ * close, destroy, and exclusive requests are never passed).
+ */
+static NANORESOURCE_INLINE int
+nanoresource_request_synchronous(struct nanoresource_request_s *request) {
+  struct nanoresource_s *resource = request->resource;
+
+  return
+    1 == resource->sync &&
+    1 == resource->opened &&
+    0 == resource->pending &&
+    0 == resource->queued &&
+    0 == resource->exclusives &&
+    0 == resource->options.weight &&
+    NANORESOURCE_REQUEST_USER == request->type &&
+    0 == request->exclusive &&
+    0 == request->err;
+}
+
+/**
+ * The result of a request run by `nanoresource_request_inline()`, written
+ * by `nanoresource_request_callback()` when the request completes so the
+ * request and its resource are not touched after the operation returns.
+ */
+struct nanoresource_request_inline_s {
+  unsigned int completed;
+  unsigned int err;
+};
+
+/**
+ * Runs a user request accepted by `nanoresource_request_synchronous()`
+ * without the queue bookkeeping of a submitted request. The request takes
+ * the head of the (empty) queue and holds the resource pending while the
+ * operation runs, so requests submitted from it (ie: a close) wait behind
+ * it and run once it completes, and it is dequeued and freed like a
+ * running request. Returns the result of the request with its sign
+ * flipped, or `-EBUSY` if the operation did not complete before returning
+ * (the resource should not be `sync` then), in which case it completes
+ * like a running request.
+ */
+static NANORESOURCE_INLINE int
+nanoresource_request_inline(
+  struct nanoresource_request_s *request,
+  nanoresource_request_work_callback_t *user
+) {
+  struct nanoresource_s *resource = request->resource;
+  struct nanoresource_request_inline_s result = { 0, 0 };
+
+  resource->queue[0] = request;
+  resource->queued = 1;
+  resource->pending++;
+  request->pending = 1;
+  request->inlined = &result;
+
+  nanoresource_request_dispatch(request, 0, 0, 0, user);
+
+  // the request may be freed, and the resource with it when the operation
+  // queued a destroy, once it completed
+  if (0 == result.completed) {
+    request->inlined = 0;
+    return -EBUSY;
+  }
+
+  return - (int) result.err;
+}
+
+/**
+ * Generates functions for a resource implementation known at compile time
+ * where the request state machine calls the operations directly instead of
+ * through the function pointers in `struct nanoresource_options_s`:
+ *
+ *   NANORESOURCE_SPECIALIZE(file, map_file, unmap_file, 0, 0)
+ *
+ *   `file_init(resource, options)`
+ *   `file_request_run(request)`
+ *   `file_submit(resource, request)`
+ *   `file_open(resource, callback)`
+ *   `file_close(resource, callback)`
+ *
+ * The operations must not be named like the generated functions (ie: a
+ * `file_open` operation for a `file` specialization).
+ *
+ * Use `0` for operations that complete right away, and for `user` to run
+ * `request->user`. The options are still set on the resource so requests
+ * drained from the queue by the library run the same operations through
+ * the generic (indirect) path.
+ */
+#define NANORESOURCE_SPECIALIZE(name, open_, close_, destroy_, user_)        \
+  static NANORESOURCE_INLINE int                                             \
+  name##_init(                                                               \
+    struct nanoresource_s *resource,                                         \
+    struct nanoresource_options_s options                                    \
+  ) {                                                                        \
+    options.open = open_;                                                    \
+    options.close = close_;                                                  \
+    options.destroy = destroy_;                                              \
+    return nanoresource_init(resource, options);                             \
+  }                                                                          \
+                                                                             \
+  static NANORESOURCE_INLINE int                                             \
+  name##_request_run(struct nanoresource_request_s *request) {               \
+    int result = 0;                                                          \
+    if (0 == nanoresource_request_begin(request, &result)) {                 \
+      return result;                                                         \
+    }                                                                        \
+    return nanoresource_request_dispatch(                                    \
+      request, open_, close_, destroy_, user_);                              \
+  }                                                                          \
+                                                                             \
+  static NANORESOURCE_INLINE int                                             \
+  name##_submit(                                                             \
+    struct nanoresource_s *resource,                                         \
+    struct nanoresource_request_s *request                                   \
+  ) {                                                                        \
+    if (                                                                     \
+      resource == request->resource &&                                       \
+      1 == nanoresource_request_synchronous(request)                         \
+    ) {                                                                      \
+      return nanoresource_request_inline(request, user_);                    \
+    }                                                                        \
+    int err = nanoresource_queue_push(resource, request);                    \
+    if (err < 0) {                                                           \
+      return err;                                                            \
+    } else if (1 == nanoresource_request_runnable(request)) {                \
+      return - name##_request_run(request);                                  \
+    } else {                                                                 \
+      return - (int) request->err;                                           \
+    }                                                                        \
+  }                                                                          \
+                                                                             \
+  static NANORESOURCE_INLINE int                                             \
+  name##_lifecycle(                                                          \
+    struct nanoresource_s *resource,                                         \
+    enum nanoresource_request_type type,                                     \
+    void *callback                                                           \
+  ) {                                                                        \
+    struct nanoresource_request_options_s options = { 0 };                   \
+    options.type = type;                                                     \
+    options.resource = resource;                                             \
+    options.callback = callback;                                             \
+    struct nanoresource_request_s *request =                                 \
+      nanoresource_request_new(options);                                     \
+    if (0 == request) {                                                      \
+      errno = NANORESOURCE_REQUEST_ALLOC_ERROR;                              \
+      return -errno;                                                         \
+    }                                                                        \
+    int err = nanoresource_queue_push(resource, request);                    \
+    if (err < 0) {                                                           \
+      nanoresource_request_free(request);                                    \
+      return err;                                                            \
+    } else if (1 == nanoresource_request_runnable(request)) {                \
+      return - name##_request_run(request);                                  \
+    } else {                                                                 \
+      return - (int) request->err;                                           \
+    }                                                                        \
+  }                                                                          \
+                                                                             \
+  static NANORESOURCE_INLINE int                                             \
+  name##_open(                                                               \
+    struct nanoresource_s *resource,                                         \
+    nanoresource_open_callback_t *callback                                   \
+  ) {                                                                        \
+    return name##_lifecycle(                                                 \
+      resource, NANORESOURCE_REQUEST_OPEN, (void *) callback);               \
+  }                                                                          \
+                                                                             \
+  static NANORESOURCE_INLINE int                                             \
+  name##_close(                                                              \
+    struct nanoresource_s *resource,                                         \
+    nanoresource_close_callback_t *callback                                  \
+  ) {                                                                        \
+    return name##_lifecycle(                                                 \
+      resource, NANORESOURCE_REQUEST_CLOSE, (void *) callback);              \
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef NANORESOURCE_TIMER_H
+#define NANORESOURCE_TIMER_H
+
+#include "platform.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+struct nanoresource_timer_s;
+
+/**
+ * The `nanoresource_timer_callback_t` callback represents the user callback
+ * called when a timer expires.
+ */
+typedef void (nanoresource_timer_callback_t)(
+  struct nanoresource_timer_s *timer);
+
+/**
+ * Fields for `struct nanoresource_timer_s` that can be used for
+ * extending structures that ensure correct memory layout.
+ */
+#define NANORESOURCE_TIMER_FIELDS             \
+  unsigned int active:1;                      \
+  uint64_t deadline;                          \
+  nanoresource_timer_callback_t *callback;    \
+  struct nanoresource_timer_s *next;          \
+  void *data;
+
+/**
+ * Represents a timer entry in the shared timer list. Timers are intrusive
+ * and owned by the caller; the library never allocates them.
+ */
+struct nanoresource_timer_s {
+  NANORESOURCE_TIMER_FIELDS
+};
+
+/**
+ * Initializes a pointer to `struct nanoresource_timer_s` with a callback
+ * and user data. Returns `0` on success, otherwise an error code found in
+ * `errno.h` with its sign flipped and `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'struct nanoresource_timer_s *timer' is `NULL`
+ */
+NANORESOURCE_EXPORT int
+nanoresource_timer_init(
+  struct nanoresource_timer_s *timer,
+  nanoresource_timer_callback_t *callback,
+  void *data);
+
+/**
+ * Starts (or restarts) a timer on the shared timer list that expires
+ * in `timeout` milliseconds.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_timer_start(
+  struct nanoresource_timer_s *timer,
+  unsigned long int timeout);
+
+/**
+ * Stops a timer removing it from the shared timer list.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_timer_stop(struct nanoresource_timer_s *timer);
+
+/**
+ * Calls the callback of every expired timer on the shared timer list and
+ * returns the number of timers that fired. Hosts should call this from
+ * their event loop, see `nanoresource_timers_timeout()`.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_timers_run();
+
+/**
+ * Returns the number of milliseconds until the next timer on the shared
+ * timer list expires, `0` if one has already expired, or `-1` if there
+ * are no active timers.
+ */
+NANORESOURCE_EXPORT long int
+nanoresource_timers_timeout();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef NANORESOURCE_TRACE_H
+#define NANORESOURCE_TRACE_H
+
+#include "platform.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+struct nanoresource_trace_event_s;
+
+/**
+ * The number of events kept in the trace ring buffer of each thread.
+ * Older events are overwritten when a ring buffer is full. A ring buffer
+ * is allocated by each thread on its first event and is never freed, see
+ * `nanoresource_trace_release()`.
+ */
+#ifndef NANORESOURCE_TRACE_EVENTS
+#define NANORESOURCE_TRACE_EVENTS 4096
+#endif
+
+/**
+ * Request lifecycle events recorded in the trace ring buffers.
+ */
+enum nanoresource_trace_event_type {
+  NANORESOURCE_TRACE_ENQUEUE = 0,
+  NANORESOURCE_TRACE_RUN = 1,
+  NANORESOURCE_TRACE_COMPLETE = 2,
+  NANORESOURCE_TRACE_FREE = 3,
+  NANORESOURCE_TRACE_NONE = NANORESOURCE_MAX_ENUM
+};
+
+/**
+ * Represents a recorded trace event. The `resource` and `request` pointers
+ * are only used as identifiers and must not be dereferenced.
+ */
+struct nanoresource_trace_event_s {
+  uint64_t timestamp;
+  const void *resource;
+  const void *request;
+  enum nanoresource_trace_event_type event;
+  unsigned int type;
+  unsigned int queued;
+  unsigned int err;
+};
+
+/**
+ * Writes the events recorded by every thread to `stream` in the Chrome
+ * trace event JSON format, which can be loaded in `chrome://tracing` and
+ * the Perfetto UI. Queue time and run time of each request are written as
+ * async slices keyed by the request. Should be called while no other thread
+ * is recording events. Returns the number of events written on success,
+ * otherwise an error code found in `errno.h` with its sign flipped and
+ * `errno` set.
+ *
+ * Possible Error Codes
+ *   * `EFAULT`: The 'FILE *stream' is `NULL`
+ *   * `ENOSYS`: The library was compiled without `NANORESOURCE_TRACE`
+ */
+NANORESOURCE_EXPORT int
+nanoresource_trace_dump(FILE *stream);
+
+/**
+ * Discards the events recorded by every thread.
+ */
+NANORESOURCE_EXPORT int
+nanoresource_trace_reset();
+
+/**
+ * Gives the trace ring buffer of the calling thread back so a thread
+ * recording its first event later reuses it instead of allocating one.
+ * Threads should call this before they exit. Their events stay in the
+ * ring buffer until another thread claims it, which records under a thread
+ * id of its own from an empty ring buffer.
+ *
+ * Possible Error Codes
+ *   * `ENOSYS`: The library was compiled without `NANORESOURCE_TRACE`
+ */
+NANORESOURCE_EXPORT int
+nanoresource_trace_release();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
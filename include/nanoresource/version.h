@@ -3,6 +3,10 @@
 
 #include "platform.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * Returns the version string for the library.
  */
@@ -40,4 +44,8 @@ nanoresource_version_patch();
 NANORESOURCE_EXPORT const unsigned long int
 nanoresource_version_revision();
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -9,48 +9,52 @@
 #define NANORESOURCE_ALLOCATOR_FREE 0
 #endif
 
-static void *(*alloc)(unsigned long int) = NANORESOURCE_ALLOCATOR_ALLOC;
-static void (*dealloc)(void *) = NANORESOURCE_ALLOCATOR_FREE;
+static void *(*nanoresource_allocator_function)(unsigned long int) =
+  NANORESOURCE_ALLOCATOR_ALLOC;
 
-static struct nanoresource_allocator_stats_s stats = { 0 };
+static void (*nanoresource_deallocator_function)(void *) =
+  NANORESOURCE_ALLOCATOR_FREE;
+
+static struct nanoresource_allocator_stats_s nanoresource_allocator_counts =
+  { 0 };
 
 const struct nanoresource_allocator_stats_s
 nanoresource_allocator_stats() {
   return (struct nanoresource_allocator_stats_s) {
-    .alloc = stats.alloc,
-    .free = stats.free
+    .alloc = nanoresource_allocator_counts.alloc,
+    .free = nanoresource_allocator_counts.free
   };
 }
 
 int
 nanoresource_allocator_alloc_count() {
-  return stats.alloc;
+  return nanoresource_allocator_counts.alloc;
 }
 
 int
 nanoresource_allocator_free_count() {
-  return stats.free;
+  return nanoresource_allocator_counts.free;
 }
 
 void
 nanoresource_allocator_set(void *(*allocator)(unsigned long int)) {
-  alloc = allocator;
+  nanoresource_allocator_function = allocator;
 }
 
 void
 nanoresource_deallocator_set(void (*deallocator)(void *)) {
-  dealloc = deallocator;
+  nanoresource_deallocator_function = deallocator;
 }
 
 void *
 nanoresource_allocator_alloc(unsigned long int size) {
   if (0 == size) {
     return 0;
-  } else if (0 != alloc) {
-    (void) stats.alloc++;
-    return alloc(size);
+  } else if (0 != nanoresource_allocator_function) {
+    (void) nanoresource_allocator_counts.alloc++;
+    return nanoresource_allocator_function(size);
   } else {
-    (void) stats.alloc++;
+    (void) nanoresource_allocator_counts.alloc++;
     return malloc(size);
   }
 }
@@ -59,11 +63,11 @@ void
 nanoresource_allocator_free(void *ptr) {
   if (0 == ptr) {
     return;
-  } else if (0 != dealloc) {
-    (void) stats.free++;
-    dealloc(ptr);
+  } else if (0 != nanoresource_deallocator_function) {
+    (void) nanoresource_allocator_counts.free++;
+    nanoresource_deallocator_function(ptr);
   } else {
-    (void) stats.free++;
+    (void) nanoresource_allocator_counts.free++;
     free(ptr);
   }
 }
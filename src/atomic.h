@@ -0,0 +1,23 @@
+#ifndef _NANORESOURCE_ATOMIC_H
+#define _NANORESOURCE_ATOMIC_H
+
+// acquire loads, release stores, relaxed counters, and a test and set spin
+// lock for the structures shared between threads, plain memory accesses
+// otherwise
+#if defined(__GNUC__)
+#define ATOMIC_LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#define ATOMIC_INCREMENT(ptr) __atomic_fetch_add(ptr, 1, __ATOMIC_RELAXED)
+#define ATOMIC_DECREMENT(ptr) __atomic_fetch_sub(ptr, 1, __ATOMIC_RELAXED)
+#define SPIN_LOCK(ptr) while (__sync_lock_test_and_set(ptr, 1)) { }
+#define SPIN_UNLOCK(ptr) __sync_lock_release(ptr)
+#else
+#define ATOMIC_LOAD(ptr) (*(ptr))
+#define ATOMIC_STORE(ptr, value) (*(ptr) = (value))
+#define ATOMIC_INCREMENT(ptr) ((*(ptr))++)
+#define ATOMIC_DECREMENT(ptr) ((*(ptr))--)
+#define SPIN_LOCK(ptr) (*(ptr) = 1)
+#define SPIN_UNLOCK(ptr) (*(ptr) = 0)
+#endif
+
+#endif
@@ -0,0 +1,9 @@
+#include "nanoresource/clock.h"
+#include <time.h>
+
+uint64_t
+nanoresource_clock_now() {
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
@@ -0,0 +1,239 @@
+#include "nanoresource/epoch.h"
+#include "require.h"
+#include "atomic.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+// the state of a thread is `epoch << 1 | 1` in a critical section and `0`
+// outside of one
+struct nanoresource_epoch_record_s {
+  struct nanoresource_epoch_record_s *next;
+  volatile int owned;
+  uint64_t state;
+  unsigned int depth;
+  unsigned int retired;
+  struct nanoresource_epoch_node_s *limbo;
+};
+
+static uint64_t nanoresource_epoch = 0;
+static struct nanoresource_epoch_record_s *nanoresource_epoch_records = 0;
+static NANORESOURCE_THREAD_LOCAL struct nanoresource_epoch_record_s *
+  nanoresource_epoch_self = 0;
+
+static struct nanoresource_epoch_record_s *
+nanoresource_epoch_record_create() {
+  struct nanoresource_epoch_record_s *it =
+    ATOMIC_LOAD(&nanoresource_epoch_records);
+
+  // records released by exited threads are reused before growing the list,
+  // they are released with an empty limbo list outside of a critical section
+  for (; 0 != it; it = it->next) {
+#if defined(__GNUC__)
+    if (__sync_bool_compare_and_swap(&it->owned, 0, 1)) {
+      return it;
+    }
+#else
+    if (0 == it->owned) {
+      it->owned = 1;
+      return it;
+    }
+#endif
+  }
+
+  // records live for the life time of the process like the trace rings
+  // and are kept out of the allocator stats on purpose
+  struct nanoresource_epoch_record_s *created = calloc(1,
+    sizeof(struct nanoresource_epoch_record_s));
+
+  if (0 == created) {
+    return 0;
+  }
+
+  created->owned = 1;
+
+#if defined(__GNUC__)
+  do {
+    created->next = ATOMIC_LOAD(&nanoresource_epoch_records);
+  } while (!__sync_bool_compare_and_swap(
+    &nanoresource_epoch_records,
+    created->next,
+    created));
+#else
+  created->next = nanoresource_epoch_records;
+  nanoresource_epoch_records = created;
+#endif
+
+  return created;
+}
+
+// the global epoch can only advance once every thread in a critical
+// section has observed it
+static void
+nanoresource_epoch_advance() {
+  const uint64_t current = ATOMIC_LOAD(&nanoresource_epoch);
+
+  struct nanoresource_epoch_record_s *it =
+    ATOMIC_LOAD(&nanoresource_epoch_records);
+
+  for (; 0 != it; it = it->next) {
+    const uint64_t state = ATOMIC_LOAD(&it->state);
+    if (1 == (state & 1) && current != state >> 1) {
+      return;
+    }
+  }
+
+#if defined(__GNUC__)
+  __sync_bool_compare_and_swap(&nanoresource_epoch, current, current + 1);
+#else
+  nanoresource_epoch = current + 1;
+#endif
+}
+
+// pointers retired in epoch `e` can be reclaimed in epoch `e + 2` as
+// readers from epoch `e - 1` and `e` have left by then
+static int
+nanoresource_epoch_reclaim() {
+  const uint64_t current = ATOMIC_LOAD(&nanoresource_epoch);
+  struct nanoresource_epoch_node_s **cursor =
+    &nanoresource_epoch_self->limbo;
+  int released = 0;
+
+  // the limbo list is ordered by epoch, newest first
+  while (0 != *cursor && (*cursor)->epoch + 2 > current) {
+    cursor = &(*cursor)->next;
+  }
+
+  struct nanoresource_epoch_node_s *it = *cursor;
+  *cursor = 0;
+
+  while (0 != it) {
+    // the node may be stored in the memory the callback releases
+    struct nanoresource_epoch_node_s *next = it->next;
+    it->callback(it->pointer);
+    (void) released++;
+    it = next;
+  }
+
+  nanoresource_epoch_self->retired -= released;
+  return released;
+}
+
+void
+nanoresource_epoch_enter() {
+  if (
+    0 == nanoresource_epoch_self &&
+    0 == (nanoresource_epoch_self = nanoresource_epoch_record_create())
+  ) {
+    return;
+  }
+
+  if (0 == nanoresource_epoch_self->depth++) {
+    ATOMIC_STORE(
+      &nanoresource_epoch_self->state,
+      ATOMIC_LOAD(&nanoresource_epoch) << 1 | 1);
+#if defined(__GNUC__)
+    // the state must be visible before any shared memory is read
+    __sync_synchronize();
+#endif
+  }
+}
+
+void
+nanoresource_epoch_leave() {
+  if (
+    0 != nanoresource_epoch_self &&
+    nanoresource_epoch_self->depth > 0 &&
+    0 == --nanoresource_epoch_self->depth
+  ) {
+    ATOMIC_STORE(&nanoresource_epoch_self->state, 0);
+  }
+}
+
+// waits until every reader that could have observed a pointer retired now
+// has left, only called by a thread without a record which can not be in a
+// critical section itself
+static void
+nanoresource_epoch_wait() {
+  const uint64_t target = ATOMIC_LOAD(&nanoresource_epoch) + 2;
+
+  while (ATOMIC_LOAD(&nanoresource_epoch) < target) {
+    nanoresource_epoch_advance();
+  }
+}
+
+int
+nanoresource_epoch_retire(
+  struct nanoresource_epoch_node_s *node,
+  void *pointer,
+  nanoresource_epoch_free_callback_t *callback
+) {
+  require(node, EFAULT);
+  require(callback, EFAULT);
+
+  if (
+    0 == nanoresource_epoch_self &&
+    0 == (nanoresource_epoch_self = nanoresource_epoch_record_create())
+  ) {
+    nanoresource_epoch_wait();
+    callback(pointer);
+    return 0;
+  }
+
+  node->epoch = ATOMIC_LOAD(&nanoresource_epoch);
+  node->pointer = pointer;
+  node->callback = callback;
+  node->next = nanoresource_epoch_self->limbo;
+  nanoresource_epoch_self->limbo = node;
+
+  if (++nanoresource_epoch_self->retired >= NANORESOURCE_EPOCH_BATCH) {
+    nanoresource_epoch_collect();
+  }
+
+  return 0;
+}
+
+int
+nanoresource_epoch_collect() {
+  if (0 == nanoresource_epoch_self) {
+    return 0;
+  }
+
+  nanoresource_epoch_advance();
+  return nanoresource_epoch_reclaim();
+}
+
+int
+nanoresource_epoch_synchronize() {
+  int released = 0;
+
+  if (0 == nanoresource_epoch_self) {
+    return 0;
+  }
+
+  while (0 != nanoresource_epoch_self->limbo) {
+    nanoresource_epoch_advance();
+    released += nanoresource_epoch_reclaim();
+  }
+
+  return released;
+}
+
+int
+nanoresource_epoch_release() {
+  if (0 == nanoresource_epoch_self) {
+    return 0;
+  }
+
+  require(0 == nanoresource_epoch_self->depth, EBUSY);
+
+  int released = nanoresource_epoch_synchronize();
+
+#if defined(__GNUC__)
+  __sync_lock_release(&nanoresource_epoch_self->owned);
+#else
+  nanoresource_epoch_self->owned = 0;
+#endif
+
+  nanoresource_epoch_self = 0;
+  return released;
+}
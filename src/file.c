@@ -0,0 +1,325 @@
+#include "nanoresource/allocator.h"
+#include "nanoresource/file.h"
+#include "nanoresource/resource.h"
+#include "require.h"
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// a read request with its arguments and result inline, freed as one block
+struct nanoresource_file_read_s {
+  struct nanoresource_request_s request;
+  uint64_t offset;
+  size_t length;
+  nanoresource_file_read_callback_t *callback;
+  struct nanoresource_file_slice_s slice;
+};
+
+static int
+nanoresource_file_advise(
+  struct nanoresource_file_map_s *mapping,
+  enum nanoresource_file_advice advice
+) {
+  switch (advice) {
+    case NANORESOURCE_FILE_SEQUENTIAL:
+      return posix_madvise(mapping->base, mapping->size, POSIX_MADV_SEQUENTIAL);
+
+    case NANORESOURCE_FILE_RANDOM:
+      return posix_madvise(mapping->base, mapping->size, POSIX_MADV_RANDOM);
+
+    default:
+      return 0;
+  }
+}
+
+static size_t
+nanoresource_file_size(struct nanoresource_file_s *file) {
+  struct stat stats = { 0 };
+
+  if (fstat(file->fd, &stats) < 0 || stats.st_size < 0) {
+    return 0;
+  }
+
+  return (size_t) stats.st_size;
+}
+
+// maps the whole file, an empty file has an empty mapping
+static struct nanoresource_file_map_s *
+nanoresource_file_map(struct nanoresource_file_s *file) {
+  struct nanoresource_file_map_s *mapping = nanoresource_allocator_alloc(
+    sizeof(struct nanoresource_file_map_s));
+
+  if (0 == mapping) {
+    errno = ENOMEM;
+    return 0;
+  }
+
+  mapping->base = 0;
+  mapping->size = nanoresource_file_size(file);
+
+  if (mapping->size > 0) {
+    mapping->base = mmap(0, mapping->size, PROT_READ, MAP_SHARED, file->fd, 0);
+
+    if (MAP_FAILED == mapping->base) {
+      nanoresource_allocator_free(mapping);
+      return 0;
+    }
+
+    nanoresource_file_advise(mapping, file->advice);
+  }
+
+  return mapping;
+}
+
+static void
+nanoresource_file_unmap(struct nanoresource_file_map_s *mapping) {
+  if (0 != mapping && 0 != mapping->base) {
+    munmap(mapping->base, mapping->size);
+  }
+
+  nanoresource_allocator_free(mapping);
+}
+
+// opens and maps the file, or maps it again for `nanoresource_reopen()`
+// which passes the current mapping in `request->data`
+static void
+nanoresource_file_open(struct nanoresource_request_s *request) {
+  struct nanoresource_file_s *file = (struct nanoresource_file_s *) request->resource;
+  struct nanoresource_file_map_s *mapping = 0;
+  int reopening = 0 != request->data;
+
+  if (0 == reopening && file->fd < 0) {
+    file->fd = open(file->filename, O_RDONLY);
+  }
+
+  if (file->fd >= 0) {
+    mapping = nanoresource_file_map(file);
+  }
+
+  if (0 == mapping) {
+    int err = errno;
+
+    if (0 == reopening && file->fd >= 0) {
+      close(file->fd);
+      file->fd = -1;
+    }
+
+    request->callback(request, err);
+    return;
+  }
+
+  if (1 == reopening) {
+    request->data = mapping;
+  } else {
+    file->resource.data = mapping;
+  }
+
+  request->callback(request, 0);
+}
+
+// unmaps a previous mapping (given in `request->data`) or the current one
+// and closes the file
+static void
+nanoresource_file_close(struct nanoresource_request_s *request) {
+  struct nanoresource_file_s *file = (struct nanoresource_file_s *) request->resource;
+
+  if (0 != request->data) {
+    nanoresource_file_unmap(request->data);
+  } else {
+    nanoresource_file_unmap(file->resource.data);
+    file->resource.data = 0;
+
+    if (file->fd >= 0) {
+      close(file->fd);
+      file->fd = -1;
+    }
+  }
+
+  request->callback(request, 0);
+}
+
+static void
+nanoresource_file_read_work(struct nanoresource_request_s *request) {
+  struct nanoresource_file_read_s *context =
+    (struct nanoresource_file_read_s *) request;
+  struct nanoresource_s *resource = request->resource;
+  struct nanoresource_file_map_s *mapping = resource->data;
+  int err = 0;
+
+  if (0 == mapping) {
+    request->callback(request, ENOLCK);
+    return;
+  }
+
+  // slices pinning the current mapping keep it until they are released,
+  // otherwise reads past the end of it are short, compared without adding
+  // to `offset` so large ranges cannot wrap
+  if (
+    (
+      context->offset > mapping->size ||
+      context->length > mapping->size - context->offset
+    ) &&
+    nanoresource_file_size((struct nanoresource_file_s *) resource) >
+      mapping->size
+  ) {
+    // a reopen still in progress or a previous mapping still pinned fail
+    // the read with `EBUSY` rather than returning a short slice
+    if ((err = nanoresource_reopen(resource, 0)) < 0) {
+      request->callback(request, (unsigned int) -err);
+      return;
+    }
+  }
+
+  if (0 == (err = nanoresource_acquire(resource, (void **) &mapping))) {
+    context->slice.map = mapping;
+
+    if (0 != mapping && context->offset < mapping->size) {
+      size_t available = mapping->size - (size_t) context->offset;
+      context->slice.data = (const char *) mapping->base + context->offset;
+      context->slice.length = context->length > available
+        ? available
+        : context->length;
+    }
+  }
+
+  request->callback(request, err < 0 ? (unsigned int) -err : (unsigned int) err);
+}
+
+static int
+nanoresource_file_read_after(
+  struct nanoresource_request_s *request,
+  unsigned int err
+) {
+  struct nanoresource_file_read_s *context =
+    (struct nanoresource_file_read_s *) request;
+
+  if (0 != context->callback) {
+    context->callback(
+      (struct nanoresource_file_s *) request->resource,
+      (int) err,
+      &context->slice);
+  }
+
+  // the request is not owned by the queue, it is freed with its arguments
+  nanoresource_allocator_free(context);
+  return 0;
+}
+
+int
+nanoresource_file_init(
+  struct nanoresource_file_s *file,
+  const struct nanoresource_file_options_s options
+) {
+  require(file, EFAULT);
+  require(options.filename, EINVAL);
+
+  int err = nanoresource_init(&file->resource,
+    (struct nanoresource_options_s) {
+      .open = nanoresource_file_open,
+      .close = nanoresource_file_close,
+    });
+
+  if (err < 0) {
+    return err;
+  }
+
+  file->filename = options.filename;
+  file->advice = options.advice;
+  file->fd = -1;
+  return 0;
+}
+
+int
+nanoresource_file_read(
+  struct nanoresource_file_s *file,
+  uint64_t offset,
+  size_t length,
+  nanoresource_file_read_callback_t *callback
+) {
+  require(file, EFAULT);
+
+#ifdef NANORESOURCE_STATIC_POOLS
+  // the read context is allocated with its arguments, no pool fits it
+  errno = ENOSYS;
+  return -errno;
+#endif
+
+  struct nanoresource_s *resource = &file->resource;
+  struct nanoresource_file_read_s *context = nanoresource_allocator_alloc(
+    sizeof(struct nanoresource_file_read_s));
+
+  require(context, EFAULT);
+  memset(context, 0, sizeof(struct nanoresource_file_read_s));
+
+  nanoresource_request_init(&context->request,
+    (struct nanoresource_request_options_s) {
+      .type = NANORESOURCE_REQUEST_USER,
+      .resource = resource,
+      .user = nanoresource_file_read_work,
+      .after = nanoresource_file_read_after,
+    });
+
+  context->offset = offset;
+  context->length = length;
+  context->callback = callback;
+
+  int err = nanoresource_queue_push(resource, &context->request);
+
+  if (err < 0) {
+    nanoresource_allocator_free(context);
+    return err;
+  }
+
+  if (1 == nanoresource_request_runnable(&context->request)) {
+    return - nanoresource_request_run(&context->request);
+  }
+
+  return 0;
+}
+
+int
+nanoresource_file_release(
+  struct nanoresource_file_s *file,
+  const struct nanoresource_file_slice_s *slice
+) {
+  require(file, EFAULT);
+  require(slice, EFAULT);
+  return nanoresource_release(&file->resource, slice->map);
+}
+
+#else
+
+int
+nanoresource_file_init(
+  struct nanoresource_file_s *file,
+  const struct nanoresource_file_options_s options
+) {
+  errno = ENOSYS;
+  return -errno;
+}
+
+int
+nanoresource_file_read(
+  struct nanoresource_file_s *file,
+  uint64_t offset,
+  size_t length,
+  nanoresource_file_read_callback_t *callback
+) {
+  errno = ENOSYS;
+  return -errno;
+}
+
+int
+nanoresource_file_release(
+  struct nanoresource_file_s *file,
+  const struct nanoresource_file_slice_s *slice
+) {
+  errno = ENOSYS;
+  return -errno;
+}
+
+#endif
@@ -0,0 +1,186 @@
+#include "nanoresource/allocator.h"
+#include "nanoresource/handle.h"
+#include "nanoresource/resource.h"
+#include "require.h"
+#include "atomic.h"
+#include <stddef.h>
+#include <string.h>
+
+#define SLOT(observer) ((struct nanoresource_handle_slot_s *) \
+  ((char *) (observer) - offsetof(struct nanoresource_handle_slot_s, observer)))
+
+// called with the table locked
+static void
+nanoresource_handles_release(
+  struct nanoresource_handles_s *handles,
+  uint32_t index
+) {
+  struct nanoresource_handle_slot_s *slot = &handles->slots[index];
+  uint32_t generation = slot->generation + 1;
+
+  // readers compare the generation before and after loading the resource,
+  // so bump it before the slot can be reused
+  ATOMIC_STORE(&slot->generation, 0 == generation ? 1 : generation);
+  ATOMIC_STORE(&slot->resource, 0);
+
+  slot->next = handles->free;
+  handles->free = index;
+  (void) handles->size--;
+}
+
+static void
+nanoresource_handles_ondestroy(
+  struct nanoresource_observer_s *observer,
+  const struct nanoresource_event_s *event
+) {
+  struct nanoresource_handles_s *handles = observer->data;
+
+  if (NANORESOURCE_REQUEST_DESTROY == event->type && 0 == event->err) {
+    nanoresource_resource_unobserve(event->resource, observer);
+    SPIN_LOCK(&handles->lock);
+    nanoresource_handles_release(
+      handles,
+      (uint32_t) (SLOT(observer) - handles->slots));
+    SPIN_UNLOCK(&handles->lock);
+  }
+}
+
+int
+nanoresource_handles_init(
+  struct nanoresource_handles_s *handles,
+  uint32_t capacity
+) {
+  require(handles, EFAULT);
+  require(capacity, EINVAL);
+  require(memset(handles, 0, sizeof(struct nanoresource_handles_s)), EFAULT);
+
+  const size_t size = sizeof(struct nanoresource_handle_slot_s) * capacity;
+
+  handles->slots = nanoresource_allocator_alloc(size);
+  require(handles->slots, ENOMEM);
+  memset(handles->slots, 0, size);
+
+  for (uint32_t i = 0; i < capacity; ++i) {
+    handles->slots[i].generation = 1;
+    handles->slots[i].next = i + 1;
+  }
+
+  handles->capacity = capacity;
+  handles->free = 0;
+  return 0;
+}
+
+void
+nanoresource_handles_destroy(struct nanoresource_handles_s *handles) {
+  if (0 == handles || 0 == handles->slots) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < handles->capacity; ++i) {
+    struct nanoresource_handle_slot_s *slot = &handles->slots[i];
+    if (0 != slot->resource) {
+      nanoresource_resource_unobserve(slot->resource, &slot->observer);
+    }
+  }
+
+  nanoresource_allocator_free(handles->slots);
+  memset(handles, 0, sizeof(struct nanoresource_handles_s));
+}
+
+nanoresource_handle_t
+nanoresource_handle_insert(
+  struct nanoresource_handles_s *handles,
+  struct nanoresource_s *resource
+) {
+  nanoresource_handle_t handle = 0;
+
+  if (0 == handles || 0 == resource) {
+    errno = EFAULT;
+    return 0;
+  }
+
+  SPIN_LOCK(&handles->lock);
+
+  if (handles->free >= handles->capacity) {
+    SPIN_UNLOCK(&handles->lock);
+    errno = ENOMEM;
+    return 0;
+  }
+
+  uint32_t index = handles->free;
+  struct nanoresource_handle_slot_s *slot = &handles->slots[index];
+
+  handles->free = slot->next;
+  (void) handles->size++;
+
+  nanoresource_observer_init(
+    &slot->observer,
+    nanoresource_handles_ondestroy,
+    handles);
+  nanoresource_resource_observe(resource, &slot->observer);
+  ATOMIC_STORE(&slot->resource, resource);
+
+  handle = (nanoresource_handle_t) slot->generation << 32 | index;
+  SPIN_UNLOCK(&handles->lock);
+  return handle;
+}
+
+struct nanoresource_s *
+nanoresource_handle_get(
+  struct nanoresource_handles_s *handles,
+  nanoresource_handle_t handle
+) {
+  const uint32_t index = (uint32_t) handle;
+  const uint32_t generation = (uint32_t) (handle >> 32);
+
+  if (0 == handles) {
+    errno = EFAULT;
+    return 0;
+  }
+
+  if (index >= handles->capacity) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  struct nanoresource_handle_slot_s *slot = &handles->slots[index];
+
+  if (generation == ATOMIC_LOAD(&slot->generation)) {
+    struct nanoresource_s *resource = ATOMIC_LOAD(&slot->resource);
+
+    // the slot was not released (and maybe reused) while loading
+    if (0 != resource && generation == ATOMIC_LOAD(&slot->generation)) {
+      return resource;
+    }
+  }
+
+  errno = ESTALE;
+  return 0;
+}
+
+int
+nanoresource_handle_remove(
+  struct nanoresource_handles_s *handles,
+  nanoresource_handle_t handle
+) {
+  const uint32_t index = (uint32_t) handle;
+  const uint32_t generation = (uint32_t) (handle >> 32);
+
+  require(handles, EFAULT);
+  require(index < handles->capacity, EINVAL);
+
+  struct nanoresource_handle_slot_s *slot = &handles->slots[index];
+
+  SPIN_LOCK(&handles->lock);
+
+  if (generation != slot->generation || 0 == slot->resource) {
+    SPIN_UNLOCK(&handles->lock);
+    errno = ESTALE;
+    return -errno;
+  }
+
+  nanoresource_resource_unobserve(slot->resource, &slot->observer);
+  nanoresource_handles_release(handles, index);
+  SPIN_UNLOCK(&handles->lock);
+  return 0;
+}
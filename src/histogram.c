@@ -0,0 +1,163 @@
+#include "nanoresource/histogram.h"
+#include "nanoresource/resource.h"
+#include "require.h"
+#include <string.h>
+
+#define SUB_BITS NANORESOURCE_HISTOGRAM_SUB_BUCKET_BITS
+#define SUB_COUNT (1u << SUB_BITS)
+
+static unsigned int
+nanoresource_histogram_msb(uint64_t value) {
+#if defined(__GNUC__)
+  return 63u - (unsigned int) __builtin_clzll(value);
+#else
+  unsigned int bit = 0;
+  while (value >>= 1) {
+    (void) bit++;
+  }
+  return bit;
+#endif
+}
+
+static unsigned int
+nanoresource_histogram_bucket_index(uint64_t value) {
+  if (value < SUB_COUNT) {
+    return (unsigned int) value;
+  }
+
+  unsigned int magnitude = nanoresource_histogram_msb(value);
+
+  if (magnitude >= NANORESOURCE_HISTOGRAM_MAGNITUDES) {
+    return NANORESOURCE_HISTOGRAM_BUCKETS - 1;
+  }
+
+  unsigned int sub = (unsigned int) (value >> (magnitude - SUB_BITS)) & (SUB_COUNT - 1);
+  return (magnitude - SUB_BITS + 1) * SUB_COUNT + sub;
+}
+
+static uint64_t
+nanoresource_histogram_bucket_upper_bound(unsigned int index) {
+  if (index < SUB_COUNT) {
+    return index;
+  }
+
+  unsigned int magnitude = index / SUB_COUNT + SUB_BITS - 1;
+  uint64_t sub = index % SUB_COUNT;
+  uint64_t lower = (SUB_COUNT + sub) << (magnitude - SUB_BITS);
+  return lower + ((uint64_t) 1 << (magnitude - SUB_BITS)) - 1;
+}
+
+int
+nanoresource_histogram_reset(struct nanoresource_histogram_s *histogram) {
+  require(histogram, EFAULT);
+  require(memset(histogram, 0, sizeof(struct nanoresource_histogram_s)), EFAULT);
+  return 0;
+}
+
+int
+nanoresource_histogram_record(
+  struct nanoresource_histogram_s *histogram,
+  uint64_t value
+) {
+  require(histogram, EFAULT);
+
+  if (0 == histogram->count || value < histogram->min) {
+    histogram->min = value;
+  }
+
+  if (value > histogram->max) {
+    histogram->max = value;
+  }
+
+  (void) histogram->buckets[nanoresource_histogram_bucket_index(value)]++;
+  (void) histogram->count++;
+  histogram->sum += value;
+  return 0;
+}
+
+int
+nanoresource_histogram_merge(
+  struct nanoresource_histogram_s *target,
+  const struct nanoresource_histogram_s *source
+) {
+  require(target, EFAULT);
+  require(source, EFAULT);
+
+  if (0 == source->count) {
+    return 0;
+  }
+
+  if (0 == target->count || source->min < target->min) {
+    target->min = source->min;
+  }
+
+  if (source->max > target->max) {
+    target->max = source->max;
+  }
+
+  for (unsigned int i = 0; i < NANORESOURCE_HISTOGRAM_BUCKETS; ++i) {
+    target->buckets[i] += source->buckets[i];
+  }
+
+  target->count += source->count;
+  target->sum += source->sum;
+  return 0;
+}
+
+uint64_t
+nanoresource_histogram_percentile(
+  const struct nanoresource_histogram_s *histogram,
+  double percentile
+) {
+  if (0 == histogram || 0 == histogram->count) {
+    return 0;
+  }
+
+  if (percentile < 0) {
+    percentile = 0;
+  } else if (percentile > 100) {
+    percentile = 100;
+  }
+
+  uint64_t target = (uint64_t) (percentile / 100 * (double) histogram->count + 0.5);
+  uint64_t seen = 0;
+
+  if (0 == target) {
+    target = 1;
+  }
+
+  for (unsigned int i = 0; i < NANORESOURCE_HISTOGRAM_BUCKETS; ++i) {
+    seen += histogram->buckets[i];
+    if (seen >= target) {
+      uint64_t value = nanoresource_histogram_bucket_upper_bound(i);
+      return value > histogram->max ? histogram->max : value;
+    }
+  }
+
+  return histogram->max;
+}
+
+int
+nanoresource_histogram_snapshot(
+  struct nanoresource_s *resource,
+  enum nanoresource_request_type type,
+  enum nanoresource_histogram_phase phase,
+  struct nanoresource_histogram_s *snapshot
+) {
+  require(resource, EFAULT);
+  require(snapshot, EFAULT);
+  require((unsigned int) type < NANORESOURCE_HISTOGRAM_TYPES, EINVAL);
+  require((unsigned int) phase < NANORESOURCE_HISTOGRAM_PHASES, EINVAL);
+
+#ifdef NANORESOURCE_HISTOGRAMS
+  require(memcpy(
+    snapshot,
+    &resource->histograms.histograms[type][phase],
+    sizeof(struct nanoresource_histogram_s)), EFAULT);
+
+  return 0;
+#else
+  errno = ENOSYS;
+  return -errno;
+#endif
+}
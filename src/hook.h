@@ -0,0 +1,63 @@
+#ifndef _NANORESOURCE_HOOK_H
+#define _NANORESOURCE_HOOK_H
+
+#include "nanoresource/observer.h"
+#include "nanoresource/resource.h"
+#include "nanoresource/trace.h"
+
+#ifdef NANORESOURCE_USDT
+#include <sys/sdt.h>
+#endif
+
+// inlined into C++ translation units by the amalgamation
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern struct nanoresource_observer_s *nanoresource_observers;
+
+void
+nanoresource_observers_emit(
+  struct nanoresource_s *resource,
+  struct nanoresource_request_s *request,
+  enum nanoresource_request_type type,
+  unsigned int err);
+
+// detaches the observers of a resource so they can be attached again
+void
+nanoresource_observers_release(struct nanoresource_s *resource);
+
+// a single branch when no observers are attached
+#define HOOK(resource, request, type, err) do {                          \
+  if (0 != nanoresource_observers || 0 != (resource)->observers) {       \
+    nanoresource_observers_emit(resource, request, type, err);           \
+  }                                                                      \
+} while (0)
+
+#ifdef NANORESOURCE_TRACE
+void
+nanoresource_trace_record(
+  enum nanoresource_trace_event_type event,
+  struct nanoresource_s *resource,
+  struct nanoresource_request_s *request);
+
+#define TRACE(event, resource, request) \
+  nanoresource_trace_record(NANORESOURCE_TRACE_##event, resource, request)
+#else
+#define TRACE(event, resource, request) (void) (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+// USDT probes (provider `nanoresource`) with the resource pointer, request
+// type, queue depth, and error as arguments, for perf, bpftrace, and friends
+#ifdef NANORESOURCE_USDT
+#define PROBE(name, resource, type, queued, err) \
+  DTRACE_PROBE4(nanoresource, name, resource, type, queued, err)
+#else
+#define PROBE(name, resource, type, queued, err) (void) (0)
+#endif
+
+#endif
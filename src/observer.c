@@ -0,0 +1,130 @@
+#include "nanoresource/clock.h"
+#include "nanoresource/observer.h"
+#include "nanoresource/resource.h"
+#include "require.h"
+#include "hook.h"
+#include <string.h>
+
+struct nanoresource_observer_s *nanoresource_observers = 0;
+
+static int
+nanoresource_observer_attach(
+  struct nanoresource_observer_s **list,
+  struct nanoresource_observer_s *observer
+) {
+  require(observer, EFAULT);
+  require(0 == observer->attached, EEXIST);
+
+  observer->next = *list;
+  observer->attached = list;
+  *list = observer;
+  return 0;
+}
+
+static int
+nanoresource_observer_detach(
+  struct nanoresource_observer_s **list,
+  struct nanoresource_observer_s *observer
+) {
+  require(observer, EFAULT);
+  require(list == observer->attached, ENOENT);
+
+  while (0 != *list) {
+    if (observer == *list) {
+      *list = observer->next;
+      observer->next = 0;
+      observer->attached = 0;
+      return 0;
+    }
+
+    list = &(*list)->next;
+  }
+
+  errno = ENOENT;
+  return -errno;
+}
+
+static void
+nanoresource_observer_notify(
+  struct nanoresource_observer_s *observer,
+  const struct nanoresource_event_s *event
+) {
+  while (0 != observer) {
+    // observers may detach themselves from the callback
+    struct nanoresource_observer_s *next = observer->next;
+
+    if (0 != observer->callback) {
+      observer->callback(observer, event);
+    }
+
+    observer = next;
+  }
+}
+
+int
+nanoresource_observer_init(
+  struct nanoresource_observer_s *observer,
+  nanoresource_observer_callback_t *callback,
+  void *data
+) {
+  require(observer, EFAULT);
+  require(memset(observer, 0, sizeof(struct nanoresource_observer_s)), EFAULT);
+
+  observer->callback = callback;
+  observer->data = data;
+  return 0;
+}
+
+int
+nanoresource_observe(struct nanoresource_observer_s *observer) {
+  return nanoresource_observer_attach(&nanoresource_observers, observer);
+}
+
+int
+nanoresource_unobserve(struct nanoresource_observer_s *observer) {
+  return nanoresource_observer_detach(&nanoresource_observers, observer);
+}
+
+int
+nanoresource_resource_observe(
+  struct nanoresource_s *resource,
+  struct nanoresource_observer_s *observer
+) {
+  require(resource, EFAULT);
+  return nanoresource_observer_attach(&resource->observers, observer);
+}
+
+int
+nanoresource_resource_unobserve(
+  struct nanoresource_s *resource,
+  struct nanoresource_observer_s *observer
+) {
+  require(resource, EFAULT);
+  return nanoresource_observer_detach(&resource->observers, observer);
+}
+
+void
+nanoresource_observers_release(struct nanoresource_s *resource) {
+  while (0 != resource->observers) {
+    nanoresource_observer_detach(&resource->observers, resource->observers);
+  }
+}
+
+void
+nanoresource_observers_emit(
+  struct nanoresource_s *resource,
+  struct nanoresource_request_s *request,
+  enum nanoresource_request_type type,
+  unsigned int err
+) {
+  const struct nanoresource_event_s event = {
+    .type = type,
+    .err = err,
+    .timestamp = nanoresource_clock_now(),
+    .resource = resource,
+    .request = request
+  };
+
+  nanoresource_observer_notify(resource->observers, &event);
+  nanoresource_observer_notify(nanoresource_observers, &event);
+}
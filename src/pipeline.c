@@ -0,0 +1,142 @@
+#include "nanoresource/allocator.h"
+#include "nanoresource/pipeline.h"
+#include "nanoresource/resource.h"
+#include "require.h"
+
+struct nanoresource_pipeline_s;
+
+struct nanoresource_pipeline_step_s {
+  struct nanoresource_request_s request;
+  struct nanoresource_pipeline_s *pipeline;
+  nanoresource_request_work_callback_t *work;
+};
+
+// the pipeline with its steps stored right after it, freed as one block
+struct nanoresource_pipeline_s {
+  struct nanoresource_s *resource;
+  nanoresource_pipeline_callback_t *callback;
+  void *data;
+  unsigned int count;
+  unsigned int completed;
+  unsigned int err;
+};
+
+// called after each step completes, the pipeline is freed with the last
+static int
+nanoresource_pipeline_after(
+  struct nanoresource_request_s *request,
+  unsigned int err
+) {
+  struct nanoresource_pipeline_s *pipeline =
+    ((struct nanoresource_pipeline_step_s *) request)->pipeline;
+
+  if (0 == pipeline->err) {
+    pipeline->err = err;
+  }
+
+  if (++pipeline->completed < pipeline->count) {
+    return 0;
+  }
+
+  if (0 != pipeline->callback) {
+    pipeline->callback(
+      pipeline->resource,
+      (int) pipeline->err,
+      pipeline->data);
+  }
+
+  nanoresource_allocator_free(pipeline);
+  return 0;
+}
+
+static void
+nanoresource_pipeline_step(struct nanoresource_request_s *request) {
+  ((struct nanoresource_pipeline_step_s *) request)->work(request);
+}
+
+int
+nanoresource_pipeline(
+  struct nanoresource_s *resource,
+  nanoresource_request_work_callback_t *const *steps,
+  unsigned int count,
+  nanoresource_pipeline_callback_t *callback,
+  void *data
+) {
+  require(resource, EFAULT);
+  require(0 == count || 0 != steps, EFAULT);
+
+#ifdef NANORESOURCE_STATIC_POOLS
+  // the pipeline is one block sized by its step count, no pool fits it
+  errno = ENOSYS;
+  return -errno;
+#endif
+
+  unsigned int highwater = resource->options.highwater;
+  unsigned int total = count + 2;
+
+  if (0 == highwater || highwater > NANORESOURCE_MAX_REQUEST_QUEUE) {
+    highwater = NANORESOURCE_MAX_REQUEST_QUEUE;
+  }
+
+  // all or nothing
+  require(resource->queued + total <= highwater, EAGAIN);
+
+  struct nanoresource_pipeline_s *pipeline = nanoresource_allocator_alloc(
+    sizeof(struct nanoresource_pipeline_s) +
+    sizeof(struct nanoresource_pipeline_step_s) * total);
+
+  require(pipeline, EFAULT);
+
+  struct nanoresource_pipeline_step_s *step =
+    (struct nanoresource_pipeline_step_s *) (pipeline + 1);
+
+  pipeline->resource = resource;
+  pipeline->callback = callback;
+  pipeline->data = data;
+  pipeline->count = total;
+  pipeline->completed = 0;
+  pipeline->err = 0;
+
+  for (unsigned int i = 0; i < total; ++i) {
+    enum nanoresource_request_type type = NANORESOURCE_REQUEST_USER;
+
+    if (0 == i) {
+      type = NANORESOURCE_REQUEST_OPEN;
+    } else if (total - 1 == i) {
+      type = NANORESOURCE_REQUEST_CLOSE;
+    }
+
+    nanoresource_request_init(&step[i].request,
+      (struct nanoresource_request_options_s) {
+        .type = type,
+        .resource = resource,
+        .user = NANORESOURCE_REQUEST_USER == type
+          ? nanoresource_pipeline_step
+          : 0,
+        .after = nanoresource_pipeline_after,
+        .data = NANORESOURCE_REQUEST_USER == type ? data : 0,
+      });
+
+    step[i].pipeline = pipeline;
+    step[i].work = NANORESOURCE_REQUEST_USER == type ? steps[i - 1] : 0;
+
+    int err = nanoresource_queue_push(resource, &step[i].request);
+
+    if (err < 0) {
+      // unwind the steps already queued so none outlives the block
+      while (i-- > 0) {
+        nanoresource_queue_remove(resource, &step[i].request);
+      }
+
+      nanoresource_allocator_free(pipeline);
+      errno = -err;
+      return err;
+    }
+  }
+
+  if (1 == nanoresource_request_runnable(&step[0].request)) {
+    nanoresource_request_run(&step[0].request);
+  }
+
+  return 0;
+}
@@ -0,0 +1,184 @@
+#include "nanoresource/allocator.h"
+#include "nanoresource/epoch.h"
+#include "nanoresource/pool.h"
+#include "pool.h"
+#include "atomic.h"
+
+// the usage counts are relaxed atomics, the free lists of the static pools
+// are guarded by the lock as resources and requests are freed from the
+// thread reclaiming them when compiled with epochs
+static struct nanoresource_pool_stats_s nanoresource_pool_usage = { 0 };
+
+#ifdef NANORESOURCE_STATIC_POOLS
+static volatile int nanoresource_pool_lock = 0;
+
+// a free slot links to the next one, slots never handed out are taken in
+// order so the pools need no initialization
+union nanoresource_resource_slot_u {
+  union nanoresource_resource_slot_u *next;
+  struct nanoresource_s resource;
+};
+
+union nanoresource_request_slot_u {
+  union nanoresource_request_slot_u *next;
+  struct nanoresource_request_s request;
+};
+
+static union nanoresource_resource_slot_u
+  nanoresource_resource_slots[NANORESOURCE_MAX_RESOURCES];
+static union nanoresource_resource_slot_u *nanoresource_free_resources = 0;
+static unsigned int nanoresource_reserved_resources = 0;
+
+static union nanoresource_request_slot_u
+  nanoresource_request_slots[NANORESOURCE_MAX_REQUESTS];
+static union nanoresource_request_slot_u *nanoresource_free_requests = 0;
+static unsigned int nanoresource_reserved_requests = 0;
+
+static union nanoresource_resource_slot_u *
+nanoresource_pool_resource_take() {
+  SPIN_LOCK(&nanoresource_pool_lock);
+  union nanoresource_resource_slot_u *slot = nanoresource_free_resources;
+
+  if (0 != slot) {
+    nanoresource_free_resources = slot->next;
+  } else if (nanoresource_reserved_resources < NANORESOURCE_MAX_RESOURCES) {
+    slot = &nanoresource_resource_slots[nanoresource_reserved_resources++];
+  }
+
+  SPIN_UNLOCK(&nanoresource_pool_lock);
+  return slot;
+}
+
+static union nanoresource_request_slot_u *
+nanoresource_pool_request_take() {
+  SPIN_LOCK(&nanoresource_pool_lock);
+  union nanoresource_request_slot_u *slot = nanoresource_free_requests;
+
+  if (0 != slot) {
+    nanoresource_free_requests = slot->next;
+  } else if (nanoresource_reserved_requests < NANORESOURCE_MAX_REQUESTS) {
+    slot = &nanoresource_request_slots[nanoresource_reserved_requests++];
+  }
+
+  SPIN_UNLOCK(&nanoresource_pool_lock);
+  return slot;
+}
+
+// slots retired by the calling thread go back to the pool before it counts
+// as exhausted, a retired slot is safe to reuse two epochs later
+static void
+nanoresource_pool_reclaim() {
+#ifdef NANORESOURCE_EPOCHS
+  nanoresource_epoch_collect();
+  nanoresource_epoch_collect();
+#endif
+}
+#endif
+
+const struct nanoresource_pool_stats_s
+nanoresource_pool_stats() {
+  struct nanoresource_pool_stats_s stats = {
+    .resources = ATOMIC_LOAD(&nanoresource_pool_usage.resources),
+    .requests = ATOMIC_LOAD(&nanoresource_pool_usage.requests)
+  };
+
+  return stats;
+}
+
+struct nanoresource_s *
+nanoresource_pool_resource_alloc() {
+#ifdef NANORESOURCE_STATIC_POOLS
+  union nanoresource_resource_slot_u *slot = nanoresource_pool_resource_take();
+
+  if (0 == slot) {
+    nanoresource_pool_reclaim();
+    slot = nanoresource_pool_resource_take();
+  }
+
+  if (0 == slot) {
+    errno = ENOMEM;
+    return 0;
+  }
+
+  (void) ATOMIC_INCREMENT(&nanoresource_pool_usage.resources);
+  return &slot->resource;
+#else
+  struct nanoresource_s *resource = nanoresource_allocator_alloc(
+    sizeof(struct nanoresource_s));
+
+  if (0 != resource) {
+    (void) ATOMIC_INCREMENT(&nanoresource_pool_usage.resources);
+  }
+
+  return resource;
+#endif
+}
+
+void
+nanoresource_pool_resource_free(void *resource) {
+  if (0 == resource) {
+    return;
+  }
+
+  (void) ATOMIC_DECREMENT(&nanoresource_pool_usage.resources);
+
+#ifdef NANORESOURCE_STATIC_POOLS
+  union nanoresource_resource_slot_u *slot = resource;
+
+  SPIN_LOCK(&nanoresource_pool_lock);
+  slot->next = nanoresource_free_resources;
+  nanoresource_free_resources = slot;
+  SPIN_UNLOCK(&nanoresource_pool_lock);
+#else
+  nanoresource_allocator_free(resource);
+#endif
+}
+
+struct nanoresource_request_s *
+nanoresource_pool_request_alloc() {
+#ifdef NANORESOURCE_STATIC_POOLS
+  union nanoresource_request_slot_u *slot = nanoresource_pool_request_take();
+
+  if (0 == slot) {
+    nanoresource_pool_reclaim();
+    slot = nanoresource_pool_request_take();
+  }
+
+  if (0 == slot) {
+    errno = EAGAIN;
+    return 0;
+  }
+
+  (void) ATOMIC_INCREMENT(&nanoresource_pool_usage.requests);
+  return &slot->request;
+#else
+  struct nanoresource_request_s *request = nanoresource_allocator_alloc(
+    sizeof(struct nanoresource_request_s));
+
+  if (0 != request) {
+    (void) ATOMIC_INCREMENT(&nanoresource_pool_usage.requests);
+  }
+
+  return request;
+#endif
+}
+
+void
+nanoresource_pool_request_free(void *request) {
+  if (0 == request) {
+    return;
+  }
+
+  (void) ATOMIC_DECREMENT(&nanoresource_pool_usage.requests);
+
+#ifdef NANORESOURCE_STATIC_POOLS
+  union nanoresource_request_slot_u *slot = request;
+
+  SPIN_LOCK(&nanoresource_pool_lock);
+  slot->next = nanoresource_free_requests;
+  nanoresource_free_requests = slot;
+  SPIN_UNLOCK(&nanoresource_pool_lock);
+#else
+  nanoresource_allocator_free(request);
+#endif
+}
@@ -0,0 +1,24 @@
+#ifndef _NANORESOURCE_POOL_H
+#define _NANORESOURCE_POOL_H
+
+#include "nanoresource/pool.h"
+#include "nanoresource/request.h"
+#include "nanoresource/resource.h"
+
+// takes a resource from the pool, or returns `0` with `errno` set to
+// `ENOMEM` when it is exhausted
+struct nanoresource_s *
+nanoresource_pool_resource_alloc();
+
+void
+nanoresource_pool_resource_free(void *resource);
+
+// takes a request from the pool, or returns `0` with `errno` set to
+// `EAGAIN` when it is exhausted
+struct nanoresource_request_s *
+nanoresource_pool_request_alloc();
+
+void
+nanoresource_pool_request_free(void *request);
+
+#endif
@@ -0,0 +1,228 @@
+#include "nanoresource/clock.h"
+#include "nanoresource/resource.h"
+#include "nanoresource/specialize.h"
+#include "require.h"
+#include "hook.h"
+#include <errno.h>
+
+struct nanoresource_request_s *
+nanoresource_queue_shift(struct nanoresource_s *resource) {
+  struct nanoresource_request_s *head = 0;
+
+  if (0 == resource) {
+    return 0;
+  }
+
+  if (resource->queued > 0) {
+    head = resource->queue[0];
+  }
+
+  // shift
+  for (unsigned int i = 1; i < resource->queued; ++i) {
+    resource->queue[i - 1] = resource->queue[i];
+  }
+
+  if (resource->queued > 0u) {
+    (void) --resource->queued;
+  }
+
+  return head;
+}
+
+struct nanoresource_request_s *
+nanoresource_queue_remove(
+  struct nanoresource_s *resource,
+  struct nanoresource_request_s *request
+) {
+  if (0 == resource || 0 == request) {
+    return 0;
+  }
+
+  for (unsigned int i = 0; i < resource->queued; ++i) {
+    if (request == resource->queue[i]) {
+      // put it at the head so shifting releases it
+      for (; i > 0; --i) {
+        resource->queue[i] = resource->queue[i - 1];
+      }
+
+      resource->queue[0] = request;
+      return nanoresource_queue_shift(resource);
+    }
+  }
+
+  return 0;
+}
+
+// returns `1` if a queued request should run before another one
+static NANORESOURCE_INLINE int
+nanoresource_queue_precedes(
+  enum nanoresource_queue_discipline discipline,
+  struct nanoresource_request_s *request,
+  struct nanoresource_request_s *other
+) {
+  if (
+    NANORESOURCE_REQUEST_USER != other->type ||
+    1 == other->exclusive ||
+    1 == other->running
+  ) {
+    return 0;
+  }
+
+  switch (discipline) {
+    case NANORESOURCE_QUEUE_PRIORITY:
+      return request->priority > other->priority;
+
+    case NANORESOURCE_QUEUE_DEADLINE:
+      return 0 != request->deadline &&
+        (0 == other->deadline || request->deadline < other->deadline);
+
+    default:
+      return 0;
+  }
+}
+
+int
+nanoresource_queue_push(
+  struct nanoresource_s *resource,
+  struct nanoresource_request_s *request
+) {
+  require(resource, EFAULT);
+  require(request, EFAULT);
+  require(resource == request->resource, EINVAL);
+
+  unsigned int highwater = resource->options.highwater;
+
+  if (0 == highwater || highwater > NANORESOURCE_MAX_REQUEST_QUEUE) {
+    highwater = NANORESOURCE_MAX_REQUEST_QUEUE;
+  }
+
+  if ((int) resource->queued < 0) {
+    resource->queued = 0;
+  }
+
+  // backpressure
+  if (resource->queued >= highwater) {
+    resource->throttled = 1;
+    errno = EAGAIN;
+    return -errno;
+  }
+
+  unsigned int index = resource->queued;
+
+  if (
+    NANORESOURCE_QUEUE_FIFO != resource->options.discipline &&
+    NANORESOURCE_REQUEST_USER == request->type &&
+    0 == request->exclusive
+  ) {
+    // the head of a pending queue is running (or parked)
+    unsigned int head = 0 == resource->pending ? 0 : 1;
+
+    while (
+      index > head &&
+      1 == nanoresource_queue_precedes(
+        resource->options.discipline,
+        request,
+        resource->queue[index - 1])
+    ) {
+      resource->queue[index] = resource->queue[index - 1];
+      (void) index--;
+    }
+  }
+
+  // push
+  resource->queue[index] = request;
+  resource->queued++;
+  request->pending = 1;
+
+#ifdef NANORESOURCE_HISTOGRAMS
+  request->queued_at = nanoresource_clock_now();
+#endif
+
+  TRACE(ENQUEUE, resource, request);
+  PROBE(request__enqueue, resource, request->type, resource->queued, 0);
+
+  return resource->queued;
+}
+
+int
+nanoresource_submit(
+  struct nanoresource_s *resource,
+  struct nanoresource_request_s *request
+) {
+  if (
+    0 != resource &&
+    0 != request &&
+    resource == request->resource &&
+    1 == nanoresource_request_synchronous(request)
+  ) {
+    return nanoresource_request_inline(request, 0);
+  }
+
+  int err = nanoresource_queue_push(resource, request);
+
+  if (err < 0) {
+    return err;
+  } else if (1 == nanoresource_request_runnable(request)) {
+    return - nanoresource_request_run(request);
+  } else {
+    return - request->err;
+  }
+}
+
+int
+nanoresource_active(struct nanoresource_s *resource) {
+  require(resource, EFAULT);
+
+  if (1 == resource->closing) {
+    return EAGAIN;
+  }
+
+  if (1 == resource->closed) {
+    return ENOLCK;
+  }
+
+  // waiting writers are not starved by new readers
+  if (resource->exclusives > 0u) {
+    return EBUSY;
+  }
+
+  resource->actives++;
+  return 0;
+}
+
+int
+nanoresource_active_shared(struct nanoresource_s *resource) {
+  return nanoresource_active(resource);
+}
+
+int
+nanoresource_inactive(struct nanoresource_s *resource) {
+  require(resource, EFAULT);
+  int released = 0;
+
+  if (resource->actives > 0u && 0u == --resource->actives) {
+    int queued = resource->queued;
+    while (queued-- > 0) {
+      struct nanoresource_request_s *request = resource->queue[0];
+      if (1 == request->exclusive) {
+        // the parked request kept the resource pending, give it back so
+        // the queue drains once the exclusive request completes
+        if (resource->pending > 0u) {
+          (void) --resource->pending;
+        }
+
+        nanoresource_request_run(request);
+        (void) released++;
+        break;
+      } else if (
+        NANORESOURCE_REQUEST_CLOSE == request->type ||
+        NANORESOURCE_REQUEST_DESTROY == request->type
+      ) {
+        nanoresource_request_run(request);
+        (void) released++;
+      }
+    }
+  }
+
+  return released;
+}
@@ -1,27 +1,109 @@
 #include "nanoresource/allocator.h"
+#include "nanoresource/epoch.h"
 #include "nanoresource/resource.h"
+#include "nanoresource/scheduler.h"
 #include "require.h"
+#include "atomic.h"
+#include "hook.h"
+#include "pool.h"
 #include <string.h>
 #include <stdlib.h>
 #include <errno.h>
 
+NANORESOURCE_STATIC_ASSERT(
+  sizeof(struct nanoresource_s) <= NANORESOURCE_RESOURCE_SIZE_BUDGET
+    + sizeof(struct nanoresource_request_s *) * NANORESOURCE_MAX_REQUEST_QUEUE
+#ifdef NANORESOURCE_HISTOGRAMS
+    + sizeof(struct nanoresource_histograms_s)
+#endif
+#ifdef NANORESOURCE_EPOCHS
+    // its own and the one in the copy of the last request
+    + sizeof(struct nanoresource_epoch_node_s) * 2
+#endif
+    , resource_size_budget);
+
 static int
-queue_and_run(
+nanoresource_run_queued(
   struct nanoresource_s *resource,
   struct nanoresource_request_s *request
 ) {
-  nanoresource_queue_push(resource, request);
-
-  if (0 == resource->pending) {
+  if (1 == nanoresource_request_runnable(request)) {
     return - nanoresource_request_run(request);
   } else {
     return - request->err;
   }
 }
 
+static int
+nanoresource_queue_and_run(
+  struct nanoresource_s *resource,
+  struct nanoresource_request_s *request
+) {
+  int err = nanoresource_queue_push(resource, request);
+
+  if (err < 0) {
+    nanoresource_request_free(request);
+    return err;
+  }
+
+  return nanoresource_run_queued(resource, request);
+}
+
+// closes a replaced generation of `resource->data` outside the queue
+static int
+nanoresource_retired(struct nanoresource_request_s *request, unsigned int err) {
+  struct nanoresource_s *resource = request->resource;
+  nanoresource_request_free(request);
+  nanoresource_inactive(resource);
+  return err;
+}
+
+// a generation whose close request could not be allocated stays in
+// `retiring` (with no refs) until it is retried
+static int
+nanoresource_retire(struct nanoresource_s *resource, void *data) {
+  struct nanoresource_request_s *request = 0;
+
+  if (data == resource->retiring) {
+    resource->retiring = 0;
+  }
+
+  if (0 == resource->options.close) {
+    return 0;
+  }
+
+  request = nanoresource_request_new(
+    (struct nanoresource_request_options_s) {
+      .resource = resource,
+      .type = NANORESOURCE_REQUEST_CLOSE,
+      .data = data,
+    });
+
+  if (0 == request) {
+    resource->retiring = data;
+    errno = NANORESOURCE_REQUEST_ALLOC_ERROR;
+    return -errno;
+  }
+
+  // close and destroy requests wait for the previous generation to close
+  (void) resource->actives++;
+  request->callback = nanoresource_retired;
+  resource->options.close(request);
+  return 0;
+}
+
+static int
+nanoresource_retire_pending(struct nanoresource_s *resource) {
+  if (0 != resource->retiring && 0u == resource->retiring_refs) {
+    return nanoresource_retire(resource, resource->retiring);
+  }
+
+  return 0;
+}
+
 struct nanoresource_s *
 nanoresource_alloc() {
-  return nanoresource_allocator_alloc(sizeof(struct nanoresource_s));
+  return nanoresource_pool_resource_alloc();
 }
 
 int
@@ -34,6 +116,7 @@ nanoresource_init(
   require(memcpy(&resource->options, &options, sizeof(struct nanoresource_options_s)), EFAULT);
 
   resource->needs_open = 1;
+  resource->sync = 0 != options.sync;
   resource->data = options.data;
   return 0;
 }
@@ -41,8 +124,10 @@ nanoresource_init(
 struct nanoresource_s *
 nanoresource_new(struct nanoresource_options_s options) {
   struct nanoresource_s *resource = nanoresource_alloc();
-  if (nanoresource_init(resource, options) < 0) {
-    nanoresource_allocator_free(resource);
+  if (0 == resource) {
+    return 0;
+  } else if (nanoresource_init(resource, options) < 0) {
+    nanoresource_pool_resource_free(resource);
     resource = 0;
   } else {
     resource->alloc = 1;
@@ -52,8 +137,22 @@ nanoresource_new(struct nanoresource_options_s options) {
 
 void
 nanoresource_free(struct nanoresource_s *resource) {
+  if (0 != resource) {
+    nanoresource_timer_stop(&resource->retry_timer);
+    nanoresource_scheduler_remove(resource);
+    nanoresource_observers_release(resource);
+  }
+
   if (0 != resource && 1 == resource->alloc) {
-    nanoresource_allocator_free(resource);
+#ifdef NANORESOURCE_EPOCHS
+    // other threads may still be reading the resource
+    nanoresource_epoch_retire(
+      &resource->retired,
+      resource,
+      nanoresource_pool_resource_free);
+#else
+    nanoresource_pool_resource_free(resource);
+#endif
   }
 }
 
@@ -88,8 +187,8 @@ nanoresource_destroy(
       .data = 0
     });
 
-  require(request, EFAULT);
-  return queue_and_run(resource, request);
+  require(request, NANORESOURCE_REQUEST_ALLOC_ERROR);
+  return nanoresource_queue_and_run(resource, request);
 }
 
 int
@@ -107,8 +206,8 @@ nanoresource_open(
       .data = 0,
     });
 
-  require(request, EFAULT);
-  return queue_and_run(resource, request);
+  require(request, NANORESOURCE_REQUEST_ALLOC_ERROR);
+  return nanoresource_queue_and_run(resource, request);
 }
 
 int
@@ -118,6 +217,9 @@ nanoresource_close(
 ) {
   require(resource, EFAULT);
 
+  // the close waits for a replaced generation if it can be closed now
+  nanoresource_retire_pending(resource);
+
   struct nanoresource_request_s *request = nanoresource_request_new(
     (struct nanoresource_request_options_s) {
       .callback = callback,
@@ -126,87 +228,154 @@ nanoresource_close(
       .data = 0,
     });
 
-  require(request, EFAULT);
-  return queue_and_run(resource, request);
+  require(request, NANORESOURCE_REQUEST_ALLOC_ERROR);
+  return nanoresource_queue_and_run(resource, request);
 }
 
-struct nanoresource_request_s *
-nanoresource_queue_shift(struct nanoresource_s *resource) {
-  struct nanoresource_request_s *head = 0;
+int
+nanoresource_active_exclusive(
+  struct nanoresource_s *resource,
+  nanoresource_request_work_callback_t *work,
+  nanoresource_user_callback_t *callback
+) {
+  require(resource, EFAULT);
+
+  struct nanoresource_request_s *request = nanoresource_request_new(
+    (struct nanoresource_request_options_s) {
+      .callback = callback,
+      .resource = resource,
+      .type = NANORESOURCE_REQUEST_USER,
+      .user = work,
+      .data = 0,
+    });
 
-  if (0 == resource) {
-    return 0;
-  }
+  require(request, NANORESOURCE_REQUEST_ALLOC_ERROR);
+  request->exclusive = 1;
+
+  int err = nanoresource_queue_push(resource, request);
 
-  if (resource->queued > 0) {
-    head = resource->queue[0];
+  if (err < 0) {
+    nanoresource_request_free(request);
+    return err;
   }
 
-  // shift
-  for (int i = 1; i < resource->queued; ++i) {
-    resource->queue[i - 1] = resource->queue[i];
+  (void) resource->exclusives++;
+  return nanoresource_run_queued(resource, request);
+}
+
+static int
+nanoresource_reopened(
+  struct nanoresource_request_s *request,
+  unsigned int err
+) {
+  struct nanoresource_s *resource = request->resource;
+  nanoresource_open_callback_t *callback = request->done;
+  void *data = request->data;
+  void *previous = resource->data;
+
+  nanoresource_request_free(request);
+  resource->reopening = 0;
+
+  if (0 == err && previous != data) {
+    // threads loading `resource->data` see the new generation initialized
+    ATOMIC_STORE(&resource->data, data);
+
+    if (resource->refs > 0u) {
+      resource->retiring = previous;
+      resource->retiring_refs = resource->refs;
+      resource->refs = 0;
+    } else {
+      nanoresource_retire(resource, previous);
+    }
   }
 
-  if (resource->queued > 0u) {
-    (void) --resource->queued;
+  if (0 != callback) {
+    callback(resource, (int) err);
   }
 
-  return head;
+  nanoresource_inactive(resource);
+  return err;
 }
 
 int
-nanoresource_queue_push(
+nanoresource_reopen(
   struct nanoresource_s *resource,
-  struct nanoresource_request_s *request
+  nanoresource_open_callback_t *callback
 ) {
   require(resource, EFAULT);
-  require(request, EFAULT);
-  require(resource == request->resource, EINVAL);
+  require(1 == resource->opened, ENOLCK);
+  require(0 == resource->reopening, EBUSY);
+  require(0 == resource->retiring_refs, EBUSY);
 
-  if ((int) resource->queued < 0) {
-    resource->queued = 0;
+  int err = nanoresource_retire_pending(resource);
+
+  if (err < 0) {
+    return err;
+  }
+
+  err = nanoresource_active(resource);
+
+  if (err > 0) {
+    errno = err;
+    return -errno;
+  } else if (err < 0) {
+    return err;
+  }
+
+  struct nanoresource_request_s *request = nanoresource_request_new(
+    (struct nanoresource_request_options_s) {
+      .callback = callback,
+      .resource = resource,
+      .type = NANORESOURCE_REQUEST_OPEN,
+      .data = resource->data,
+    });
+
+  if (0 == request) {
+    nanoresource_inactive(resource);
+    errno = NANORESOURCE_REQUEST_ALLOC_ERROR;
+    return -errno;
+  }
+
+  resource->reopening = 1;
+  request->callback = nanoresource_reopened;
+
+  if (0 != resource->options.open) {
+    resource->options.open(request);
+  } else {
+    nanoresource_reopened(request, 0);
   }
 
-  // push
-  resource->queue[resource->queued++] = request;
-  request->pending = 1;
-  return resource->queued;
+  return 0;
 }
 
 int
-nanoresource_active(struct nanoresource_s *resource) {
+nanoresource_acquire(struct nanoresource_s *resource, void **data) {
   require(resource, EFAULT);
+  require(data, EFAULT);
 
-  if (1 == resource->closing) {
-    return EAGAIN;
-  }
+  int err = nanoresource_active(resource);
 
-  if (1 == resource->closed) {
-    return ENOLCK;
+  if (0 != err) {
+    return err;
   }
 
-  resource->actives++;
+  (void) resource->refs++;
+  *data = resource->data;
   return 0;
 }
 
 int
-nanoresource_inactive(struct nanoresource_s *resource) {
+nanoresource_release(struct nanoresource_s *resource, void *data) {
   require(resource, EFAULT);
-  int released = 0;
-
-  if (resource->actives > 0u && 0u == --resource->actives) {
-    int queued = resource->queued;
-    while (queued-- > 0) {
-      struct nanoresource_request_s *request = resource->queue[0];
-      if (
-        NANORESOURCE_REQUEST_CLOSE == request->type ||
-        NANORESOURCE_REQUEST_DESTROY == request->type
-      ) {
-        nanoresource_request_run(request);
-        (void) released++;
-      }
-    }
+
+  if (resource->retiring_refs > 0u && data == resource->retiring) {
+    (void) --resource->retiring_refs;
+  } else if (resource->refs > 0u) {
+    (void) --resource->refs;
   }
 
-  return released;
+  // closes a replaced generation once its last user released it
+  nanoresource_retire_pending(resource);
+
+  return nanoresource_inactive(resource);
 }
@@ -0,0 +1,170 @@
+#include "nanoresource/resource.h"
+#include "nanoresource/scheduler.h"
+#include "require.h"
+#include "scheduler.h"
+
+// intrusive list of resources with a request waiting to start
+static struct nanoresource_s *nanoresource_scheduler_head = 0;
+static struct nanoresource_s *nanoresource_scheduler_tail = 0;
+static unsigned int nanoresource_scheduler_waiting = 0;
+
+// the resource taking its turn, `0` if it was freed during its turn
+static struct nanoresource_s *nanoresource_scheduler_current = 0;
+static int nanoresource_scheduler_running = 0;
+
+static void
+nanoresource_scheduler_append(struct nanoresource_s *resource) {
+  resource->next_runnable = 0;
+
+  if (0 == nanoresource_scheduler_tail) {
+    nanoresource_scheduler_head = resource;
+  } else {
+    nanoresource_scheduler_tail->next_runnable = resource;
+  }
+
+  nanoresource_scheduler_tail = resource;
+  (void) nanoresource_scheduler_waiting++;
+}
+
+static int
+nanoresource_scheduler_budgeted(unsigned int budget, unsigned int started) {
+  return 0 == budget || started < budget;
+}
+
+int
+nanoresource_scheduler_wake(struct nanoresource_s *resource) {
+  require(resource, EFAULT);
+
+  if (1 == resource->runnable) {
+    return 0;
+  }
+
+  resource->runnable = 1;
+
+  // the resource taking its turn is appended when the turn ends
+  if (resource != nanoresource_scheduler_current) {
+    nanoresource_scheduler_append(resource);
+  }
+
+  return 0;
+}
+
+int
+nanoresource_scheduler_run(unsigned int budget) {
+  unsigned int started = 0;
+
+  // requests started by the scheduler completing synchronously only wake
+  // their resource, so nested calls have nothing to do
+  if (1 == nanoresource_scheduler_running) {
+    return 0;
+  }
+
+  nanoresource_scheduler_running = 1;
+
+  while (
+    0 != nanoresource_scheduler_head &&
+    1 == nanoresource_scheduler_budgeted(budget, started)
+  ) {
+    struct nanoresource_s *resource = nanoresource_scheduler_head;
+
+    nanoresource_scheduler_head = resource->next_runnable;
+    resource->next_runnable = 0;
+    (void) nanoresource_scheduler_waiting--;
+
+    if (0 == nanoresource_scheduler_head) {
+      nanoresource_scheduler_tail = 0;
+    }
+
+    nanoresource_scheduler_current = resource;
+    resource->deficit += resource->options.weight * NANORESOURCE_SCHEDULER_QUANTUM;
+
+    while (
+      resource == nanoresource_scheduler_current &&
+      1 == resource->runnable &&
+      resource->deficit > 0u &&
+      1 == nanoresource_scheduler_budgeted(budget, started)
+    ) {
+      resource->runnable = 0;
+      (void) resource->deficit--;
+
+      // the resource was held pending while it waited, give it back
+      if (resource->pending > 0u) {
+        (void) --resource->pending;
+      }
+
+      if (0 == resource->queued) {
+        continue;
+      }
+
+      (void) started++;
+      resource->scheduled = 1;
+      nanoresource_request_run(resource->queue[0]);
+
+      if (resource == nanoresource_scheduler_current) {
+        resource->scheduled = 0;
+      }
+    }
+
+    if (resource != nanoresource_scheduler_current) {
+      continue;
+    }
+
+    if (1 == resource->runnable) {
+      // out of credit (or budget), the rest waits for the next round
+      nanoresource_scheduler_append(resource);
+    } else {
+      // credit is not banked while a resource has nothing waiting
+      resource->deficit = 0;
+    }
+  }
+
+  nanoresource_scheduler_current = 0;
+  nanoresource_scheduler_running = 0;
+  return (int) started;
+}
+
+unsigned int
+nanoresource_scheduler_runnable() {
+  return nanoresource_scheduler_waiting;
+}
+
+int
+nanoresource_scheduler_remove(struct nanoresource_s *resource) {
+  require(resource, EFAULT);
+
+  struct nanoresource_s *previous = 0;
+
+  if (resource == nanoresource_scheduler_current) {
+    nanoresource_scheduler_current = 0;
+  }
+
+  if (0 == resource->runnable) {
+    return 0;
+  }
+
+  resource->runnable = 0;
+
+  struct nanoresource_s *it = nanoresource_scheduler_head;
+
+  for (; 0 != it; it = it->next_runnable) {
+    if (resource == it) {
+      if (0 == previous) {
+        nanoresource_scheduler_head = it->next_runnable;
+      } else {
+        previous->next_runnable = it->next_runnable;
+      }
+
+      if (nanoresource_scheduler_tail == it) {
+        nanoresource_scheduler_tail = previous;
+      }
+
+      it->next_runnable = 0;
+      (void) nanoresource_scheduler_waiting--;
+      break;
+    }
+
+    previous = it;
+  }
+
+  return 0;
+}
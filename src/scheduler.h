@@ -0,0 +1,20 @@
+#ifndef _NANORESOURCE_SCHEDULER_H
+#define _NANORESOURCE_SCHEDULER_H
+
+#include "nanoresource/resource.h"
+#include "nanoresource/scheduler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// appends a held (pending) resource to the runnable list of the shared
+// scheduler unless it is already waiting
+int
+nanoresource_scheduler_wake(struct nanoresource_s *resource);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,516 @@
+#include "nanoresource/clock.h"
+#include "nanoresource/resource.h"
+#include "nanoresource/request.h"
+#include "nanoresource/specialize.h"
+#include "nanoresource/timer.h"
+#include "require.h"
+#include "hook.h"
+#include "scheduler.h"
+#include <stddef.h>
+#include <string.h>
+
+static NANORESOURCE_INLINE int
+nanoresource_request_dequeue(
+  struct nanoresource_request_s *request,
+  struct nanoresource_s *resource,
+  enum nanoresource_request_type type,
+  unsigned int err
+);
+
+// user requests run concurrently up to the `max_inflight` option
+static NANORESOURCE_INLINE int
+nanoresource_request_concurrent(struct nanoresource_request_s *request) {
+  return
+    NANORESOURCE_REQUEST_USER == request->type &&
+    0 == request->exclusive &&
+    request->resource->options.max_inflight > 1u;
+}
+
+// returns the user request queued right behind the running ones if there
+// is a free concurrent slot for it, otherwise `0`
+static NANORESOURCE_INLINE struct nanoresource_request_s *
+nanoresource_request_next(struct nanoresource_s *resource) {
+  if (
+    resource->pending != resource->inflight ||
+    resource->inflight >= resource->options.max_inflight ||
+    resource->queued <= resource->inflight
+  ) {
+    return 0;
+  }
+
+  struct nanoresource_request_s *next = resource->queue[resource->inflight];
+
+  if (0 != next->err || 0 == nanoresource_request_concurrent(next)) {
+    return 0;
+  }
+
+  return next;
+}
+
+#ifdef NANORESOURCE_HISTOGRAMS
+static NANORESOURCE_INLINE void
+nanoresource_request_record(struct nanoresource_request_s *request) {
+  struct nanoresource_histogram_s *histograms = 0;
+  uint64_t now = nanoresource_clock_now();
+
+  if ((unsigned int) request->type >= NANORESOURCE_HISTOGRAM_TYPES) {
+    return;
+  }
+
+  histograms = request->resource->histograms.histograms[request->type];
+
+  if (0 != request->started_at) {
+    if (0 != request->queued_at && request->started_at >= request->queued_at) {
+      nanoresource_histogram_record(
+        &histograms[NANORESOURCE_HISTOGRAM_QUEUED],
+        request->started_at - request->queued_at);
+    }
+
+    nanoresource_histogram_record(
+      &histograms[NANORESOURCE_HISTOGRAM_RUNNING],
+      now - request->started_at);
+  }
+}
+#endif
+
+static NANORESOURCE_INLINE unsigned int
+nanoresource_request_retry_random() {
+  static unsigned int seed = 0;
+
+  if (0 == seed) {
+    seed = (unsigned int) nanoresource_clock_now() | 1u;
+  }
+
+  // xorshift32
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+static NANORESOURCE_INLINE void
+nanoresource_request_retry_timeout(struct nanoresource_timer_s *timer) {
+  struct nanoresource_request_s *request =
+    (struct nanoresource_request_s *) timer->data;
+
+  // the parked open request kept the resource pending, give it back
+  // before running the request again
+  if (request->resource->pending > 0u) {
+    (void) --request->resource->pending;
+  }
+
+  request->err = 0;
+  nanoresource_request_run(request);
+}
+
+static NANORESOURCE_INLINE int
+nanoresource_request_retry(struct nanoresource_request_s *request) {
+  struct nanoresource_s *resource = request->resource;
+  const struct nanoresource_retry_options_s retry = resource->options.retry;
+  unsigned long int delay = retry.delay;
+
+  if (resource->retries >= retry.attempts) {
+    resource->retries = 0;
+    return 0;
+  }
+
+  for (unsigned int i = 0; i < resource->retries; ++i) {
+    if (0 != retry.max_delay && delay >= retry.max_delay) {
+      break;
+    } else if (delay > (unsigned long int) -1 / 2) {
+      break;
+    }
+
+    delay *= 2;
+  }
+
+  if (0 != retry.max_delay && delay > retry.max_delay) {
+    delay = retry.max_delay;
+  }
+
+  if (retry.jitter > 0u && delay > 0u) {
+    unsigned long int jitter = retry.jitter > 100u ? 100u : retry.jitter;
+    unsigned long int spread = delay / 100 * jitter + delay % 100 * jitter / 100;
+    delay -= nanoresource_request_retry_random() % (spread + 1);
+  }
+
+  (void) resource->retries++;
+
+  nanoresource_timer_init(
+    &resource->retry_timer,
+    nanoresource_request_retry_timeout,
+    request);
+
+  nanoresource_timer_start(&resource->retry_timer, delay);
+  return 1;
+}
+
+int
+nanoresource_request_begin(
+  struct nanoresource_request_s *request,
+  int *result
+) {
+  *result = 0;
+
+  if (0 == request || 0 == request->resource) {
+    errno = EFAULT;
+    *result = -errno;
+    return 0;
+  }
+
+  if (0 != request->err) {
+    *result = nanoresource_request_callback(request, request->err);
+    return 0;
+  }
+
+  // weighted resources start requests when the shared scheduler gives them
+  // a turn, and are held pending until then
+  if (
+    request->resource->options.weight > 0u &&
+    0 == request->resource->pending
+  ) {
+    if (0 == request->resource->scheduled) {
+      request->resource->pending++;
+      nanoresource_scheduler_wake(request->resource);
+      return 0;
+    }
+
+    request->resource->scheduled = 0;
+  }
+
+  request->resource->pending++;
+
+  if (0 != request->before) {
+    request->before(request, request->err);
+  }
+
+  if (
+    NANORESOURCE_REQUEST_CLOSE == request->type ||
+    NANORESOURCE_REQUEST_DESTROY == request->type ||
+    1 == request->exclusive
+  ) {
+    if (request->resource->actives > 0 || 1 == request->resource->opening) {
+      return 0;
+    }
+  }
+
+  if (1 == nanoresource_request_concurrent(request)) {
+    request->running = 1;
+    (void) request->resource->inflight++;
+  }
+
+#ifdef NANORESOURCE_HISTOGRAMS
+  request->started_at = nanoresource_clock_now();
+#endif
+
+  TRACE(RUN, request->resource, request);
+  PROBE(request__run,
+    request->resource, request->type, request->resource->queued, 0);
+
+  // the payload is per call context of the caller, it is not kept
+  memcpy(
+    &(request->resource->last_request),
+    request,
+#if NANORESOURCE_REQUEST_PAYLOAD_SIZE > 0
+    offsetof(struct nanoresource_request_s, payload));
+#else
+    sizeof(struct nanoresource_request_s));
+#endif
+
+  request->resource->last_request.data = 0;
+  request->resource->last_request.done = 0;
+  request->resource->last_request.after = 0;
+  request->resource->last_request.before = 0;
+  request->resource->last_request.callback = 0;
+
+  return 1;
+}
+
+int
+nanoresource_request_runnable(struct nanoresource_request_s *request) {
+  if (0 == request || 0 == request->resource) {
+    return 0;
+  }
+
+  struct nanoresource_s *resource = request->resource;
+
+  if (0 == resource->pending) {
+    return 1;
+  }
+
+  return
+    1 == nanoresource_request_concurrent(request) &&
+    resource->pending == resource->inflight &&
+    resource->inflight < resource->options.max_inflight &&
+    resource->queued == resource->inflight + 1;
+}
+
+int
+nanoresource_request_run(struct nanoresource_request_s *request) {
+  int result = 0;
+
+  if (0 == nanoresource_request_begin(request, &result)) {
+    return result;
+  }
+
+  // concurrent user requests claim the next one before they are dispatched
+  // so the resource outlives requests completing synchronously
+  for (struct nanoresource_request_s *it = request; 0 != it;) {
+    struct nanoresource_s *resource = it->resource;
+    struct nanoresource_request_s *next = 0;
+
+    if (1 == it->running) {
+      next = nanoresource_request_next(resource);
+      if (0 != next && 0 == nanoresource_request_begin(next, &result)) {
+        next = 0;
+      }
+    }
+
+    int err = nanoresource_request_dispatch(
+      it,
+      resource->options.open,
+      resource->options.close,
+      resource->options.destroy,
+      0);
+
+    if (it == request) {
+      result = err;
+    }
+
+    it = next;
+  }
+
+  return result;
+}
+
+static NANORESOURCE_INLINE int
+nanoresource_request_dequeue(
+  struct nanoresource_request_s *request,
+  struct nanoresource_s *resource,
+  enum nanoresource_request_type type,
+  unsigned int err
+) {
+  require(request, EFAULT);
+  require(request->resource, EFAULT);
+
+  int needs_free = 0;
+
+  // maybe open error?
+  if (err > 0) {
+    if (NANORESOURCE_REQUEST_OPEN == type) {
+      for (unsigned int i = 0; i < resource->queued; ++i) {
+        if (0 != resource->queue[i]) {
+          resource->queue[i]->err = err;
+        }
+      }
+    }
+
+    if (type < NANORESOURCE_REQUEST_USER) {
+      HOOK(resource, request, type, err);
+      PROBE(resource__error, resource, type, resource->queued, err);
+    }
+  } else {
+    switch (type) {
+      case NANORESOURCE_REQUEST_OPEN:
+        resource->retries = 0;
+        if (0 == resource->opened) {
+          resource->opened = 1;
+          resource->needs_open = 0;
+          HOOK(resource, request, NANORESOURCE_REQUEST_OPEN, 0);
+          PROBE(resource__open, resource, type, resource->queued, 0);
+        }
+        break;
+
+      case NANORESOURCE_REQUEST_CLOSE:
+        if (0 == resource->closed) {
+          resource->opened = 0;
+          resource->closed = 1;
+          HOOK(resource, request, NANORESOURCE_REQUEST_CLOSE, 0);
+          PROBE(resource__close, resource, type, resource->queued, 0);
+        }
+        break;
+
+      case NANORESOURCE_REQUEST_DESTROY:
+        if (0 == resource->destroyed) {
+          resource->destroyed = 1;
+          HOOK(resource, request, NANORESOURCE_REQUEST_DESTROY, 0);
+          PROBE(resource__destroy, resource, type, resource->queued, 0);
+        }
+        break;
+
+      default:
+        // NOOP
+        (void)(0);
+    }
+  }
+
+  if (1 == request->exclusive && resource->exclusives > 0u) {
+    (void) --resource->exclusives;
+  }
+
+  struct nanoresource_request_s *head = resource->queue[0];
+  unsigned int queued = resource->queued;
+  if (1 == request->running) {
+    // concurrent user requests complete in any order
+    (void) --resource->inflight;
+    nanoresource_queue_remove(resource, request);
+    needs_free = 1;
+    request = 0;
+    head = 0;
+  } else if (queued > 0 && head == request) {
+    nanoresource_queue_shift(resource);
+    needs_free = 1;
+    request = 0;
+    head = 0;
+  }
+
+  const int drained = resource->pending > 0u && 0u == --resource->pending;
+
+  // fired once the dequeue settled so the drain callback can push requests
+  // without racing it, and before queued requests run as they may destroy
+  // the resource
+  if (
+    1 == resource->throttled &&
+    resource->queued <= resource->options.lowwater
+  ) {
+    resource->throttled = 0;
+
+    if (0 != resource->options.drain) {
+      resource->options.drain(resource);
+    }
+  }
+
+  // drain queue, unless the drain callback already started a request
+  if (1 == drained && 0u == resource->pending) {
+    while (resource->queued > 0) {
+      if (0 == resource->queue[0]) {
+        nanoresource_queue_shift(resource);
+      }
+
+      if (nanoresource_request_run(resource->queue[0]) < 0) {
+        break;
+      }
+
+      if (type >= NANORESOURCE_REQUEST_OPEN) { // [ open, close, destroy ]
+        break;
+      } else {
+        nanoresource_request_free(nanoresource_queue_shift(resource));
+      }
+    }
+  } else if (0 == drained && resource->inflight > 0u) {
+    // a concurrent request completed while others still run
+    struct nanoresource_request_s *next = nanoresource_request_next(resource);
+    if (0 != next) {
+      nanoresource_request_run(next);
+    }
+  }
+
+  return needs_free;
+}
+
+int
+nanoresource_request_callback(
+  struct nanoresource_request_s *request,
+  unsigned int err
+) {
+  require(request, EFAULT);
+  require(request->resource, EFAULT);
+
+  request->err = err;
+
+  // park failed open requests (and everything queued behind them)
+  // until the retry policy gives up
+  if (
+    err > 0 &&
+    NANORESOURCE_REQUEST_OPEN == request->type &&
+    1 == nanoresource_request_retry(request)
+  ) {
+    return 0;
+  }
+
+  // the caller of `nanoresource_request_inline()` reads the result instead
+  // of the request, which may be freed by the time the operation returns
+  if (0 != request->inlined) {
+    request->inlined->completed = 1;
+    request->inlined->err = err;
+    request->inlined = 0;
+  }
+
+#ifdef NANORESOURCE_HISTOGRAMS
+  nanoresource_request_record(request);
+#endif
+
+  TRACE(COMPLETE, request->resource, request);
+  PROBE(request__complete,
+    request->resource, request->type, request->resource->queued, err);
+
+  struct nanoresource_s *resource = request->resource;
+  nanoresource_request_result_callback_t *after = request->after;
+  nanoresource_request_complete_callback_t *complete = request->complete;
+
+  unsigned int type = request->type;
+  void *done = request->done;
+
+  // cleared before the queue drains so requests queued right behind a
+  // lifecycle request (ie: a pipeline) are not held back by it
+  switch (type) {
+    case NANORESOURCE_REQUEST_OPEN:
+      resource->opening = 0;
+      break;
+
+    case NANORESOURCE_REQUEST_CLOSE:
+      resource->closing = 0;
+      break;
+
+    case NANORESOURCE_REQUEST_DESTROY:
+      resource->destroying = 0;
+      break;
+  }
+
+  int needs_free = nanoresource_request_dequeue(
+    request, resource, (enum nanoresource_request_type) type, err);
+
+  switch (type) {
+    case NANORESOURCE_REQUEST_OPEN:
+      if (0 != done) {
+        ((nanoresource_open_callback_t *)done)(resource, err);
+      }
+      break;
+
+    case NANORESOURCE_REQUEST_CLOSE:
+      if (0 != done) {
+        ((nanoresource_close_callback_t *)done)(resource, err);
+      }
+      break;
+
+    case NANORESOURCE_REQUEST_DESTROY:
+      if (0 != done) {
+        ((nanoresource_destroy_callback_t *)done)(resource, err);
+      }
+      break;
+
+    case NANORESOURCE_REQUEST_USER:
+      if (0 != done) {
+        ((nanoresource_user_callback_t *)done)(resource, err);
+      }
+      break;
+  }
+
+  if (0 != complete) {
+    complete(request, (int) err);
+  }
+
+  // requests not owned by the library (ie: stored in a coroutine frame)
+  // must not be touched once `after()` returns
+  needs_free = 1 == needs_free && 1 == request->alloc;
+
+  if (0 != after) {
+    after(request, err);
+  }
+
+  if (1 == needs_free) {
+    nanoresource_request_free(request);
+  }
+
+  return err;
+}
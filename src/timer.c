@@ -0,0 +1,109 @@
+#include "nanoresource/clock.h"
+#include "nanoresource/timer.h"
+#include "require.h"
+#include <string.h>
+
+static struct nanoresource_timer_s *nanoresource_timers_head = 0;
+
+int
+nanoresource_timer_init(
+  struct nanoresource_timer_s *timer,
+  nanoresource_timer_callback_t *callback,
+  void *data
+) {
+  require(timer, EFAULT);
+  require(memset(timer, 0, sizeof(struct nanoresource_timer_s)), EFAULT);
+
+  timer->callback = callback;
+  timer->data = data;
+  return 0;
+}
+
+int
+nanoresource_timer_start(
+  struct nanoresource_timer_s *timer,
+  unsigned long int timeout
+) {
+  require(timer, EFAULT);
+
+  struct nanoresource_timer_s **cursor = &nanoresource_timers_head;
+
+  nanoresource_timer_stop(timer);
+
+  timer->deadline = nanoresource_clock_now() + (uint64_t) timeout * 1000000u;
+
+  // keep the list sorted by deadline, inserting after equal deadlines
+  while (0 != *cursor && (*cursor)->deadline <= timer->deadline) {
+    cursor = &(*cursor)->next;
+  }
+
+  timer->next = *cursor;
+  timer->active = 1;
+  *cursor = timer;
+  return 0;
+}
+
+int
+nanoresource_timer_stop(struct nanoresource_timer_s *timer) {
+  require(timer, EFAULT);
+
+  struct nanoresource_timer_s **cursor = &nanoresource_timers_head;
+
+  if (0 == timer->active) {
+    return 0;
+  }
+
+  while (0 != *cursor) {
+    if (timer == *cursor) {
+      *cursor = timer->next;
+      break;
+    }
+
+    cursor = &(*cursor)->next;
+  }
+
+  timer->next = 0;
+  timer->active = 0;
+  return 0;
+}
+
+int
+nanoresource_timers_run() {
+  uint64_t now = nanoresource_clock_now();
+  int fired = 0;
+
+  while (
+    0 != nanoresource_timers_head &&
+    nanoresource_timers_head->deadline <= now
+  ) {
+    struct nanoresource_timer_s *timer = nanoresource_timers_head;
+
+    nanoresource_timers_head = timer->next;
+    timer->next = 0;
+    timer->active = 0;
+    (void) fired++;
+
+    if (0 != timer->callback) {
+      timer->callback(timer);
+    }
+  }
+
+  return fired;
+}
+
+long int
+nanoresource_timers_timeout() {
+  if (0 == nanoresource_timers_head) {
+    return -1;
+  }
+
+  uint64_t now = nanoresource_clock_now();
+
+  if (nanoresource_timers_head->deadline <= now) {
+    return 0;
+  }
+
+  // round up so a host sleeping for the timeout never wakes up early
+  return (long int)
+    ((nanoresource_timers_head->deadline - now + 999999u) / 1000000u);
+}
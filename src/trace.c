@@ -0,0 +1,252 @@
+#include "nanoresource/request.h"
+#include "nanoresource/resource.h"
+#include "nanoresource/trace.h"
+#include "require.h"
+#include "hook.h"
+
+#ifdef NANORESOURCE_TRACE
+
+#include "nanoresource/clock.h"
+#include <stdlib.h>
+
+struct nanoresource_trace_ring_s {
+  struct nanoresource_trace_ring_s *next;
+  volatile int owned;
+  unsigned int thread;
+  uint64_t count;
+  struct nanoresource_trace_event_s events[NANORESOURCE_TRACE_EVENTS];
+};
+
+static struct nanoresource_trace_ring_s *nanoresource_trace_rings = 0;
+static unsigned int nanoresource_trace_threads = 0;
+static NANORESOURCE_THREAD_LOCAL struct nanoresource_trace_ring_s *
+  nanoresource_trace_self = 0;
+
+static const char *
+nanoresource_trace_type_name(unsigned int type) {
+  switch (type) {
+    case NANORESOURCE_REQUEST_OPEN: return "open";
+    case NANORESOURCE_REQUEST_CLOSE: return "close";
+    case NANORESOURCE_REQUEST_DESTROY: return "destroy";
+    case NANORESOURCE_REQUEST_USER: return "user";
+    default: return "none";
+  }
+}
+
+// gives a ring to a new thread, events of the previous owner are dropped
+// so they are not attributed to the new one
+static struct nanoresource_trace_ring_s *
+nanoresource_trace_ring_claim(struct nanoresource_trace_ring_s *ring) {
+#if defined(__GNUC__)
+  ring->thread = __sync_add_and_fetch(&nanoresource_trace_threads, 1);
+#else
+  ring->thread = ++nanoresource_trace_threads;
+#endif
+  ring->count = 0;
+  return ring;
+}
+
+static struct nanoresource_trace_ring_s *
+nanoresource_trace_ring_create() {
+  struct nanoresource_trace_ring_s *it = nanoresource_trace_rings;
+
+  // rings released by exited threads are reused before growing the list
+  for (; 0 != it; it = it->next) {
+#if defined(__GNUC__)
+    if (__sync_bool_compare_and_swap(&it->owned, 0, 1)) {
+      return nanoresource_trace_ring_claim(it);
+    }
+#else
+    if (0 == it->owned) {
+      it->owned = 1;
+      return nanoresource_trace_ring_claim(it);
+    }
+#endif
+  }
+
+  // trace buffers live for the life time of the process and are kept
+  // out of the allocator stats on purpose
+  struct nanoresource_trace_ring_s *created = calloc(1,
+    sizeof(struct nanoresource_trace_ring_s));
+
+  if (0 == created) {
+    return 0;
+  }
+
+  created->owned = 1;
+  nanoresource_trace_ring_claim(created);
+
+#if defined(__GNUC__)
+  do {
+    created->next = nanoresource_trace_rings;
+  } while (!__sync_bool_compare_and_swap(
+    &nanoresource_trace_rings,
+    created->next,
+    created));
+#else
+  created->next = nanoresource_trace_rings;
+  nanoresource_trace_rings = created;
+#endif
+
+  return created;
+}
+
+void
+nanoresource_trace_record(
+  enum nanoresource_trace_event_type event,
+  struct nanoresource_s *resource,
+  struct nanoresource_request_s *request
+) {
+  if (
+    0 == nanoresource_trace_self &&
+    0 == (nanoresource_trace_self = nanoresource_trace_ring_create())
+  ) {
+    return;
+  }
+
+  struct nanoresource_trace_event_s *entry =
+    &nanoresource_trace_self->events[
+      nanoresource_trace_self->count++ % NANORESOURCE_TRACE_EVENTS];
+
+  entry->timestamp = nanoresource_clock_now();
+  entry->resource = resource;
+  entry->request = request;
+  entry->event = event;
+  entry->type = 0 != request ? request->type : NANORESOURCE_REQUEST_NONE;
+  entry->queued = 0 != resource ? resource->queued : 0;
+  entry->err = 0 != request ? request->err : 0;
+}
+
+static void
+nanoresource_trace_write_event(
+  FILE *stream,
+  unsigned int thread,
+  const struct nanoresource_trace_event_s *entry,
+  const char *phase,
+  const char *name,
+  int *first
+) {
+  fprintf(stream,
+    "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"id\":\"%p\","
+    "\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"resource\":\"%p\","
+    "\"queued\":%u,\"err\":%u}}",
+    *first ? "" : ",",
+    name,
+    nanoresource_trace_type_name(entry->type),
+    phase,
+    entry->request,
+    thread,
+    (double) entry->timestamp / 1000.0,
+    entry->resource,
+    entry->queued,
+    entry->err);
+
+  *first = 0;
+}
+
+int
+nanoresource_trace_dump(FILE *stream) {
+  require(stream, EFAULT);
+
+  int first = 1;
+  int written = 0;
+
+  fprintf(stream, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+  struct nanoresource_trace_ring_s *it = nanoresource_trace_rings;
+
+  for (; 0 != it; it = it->next) {
+    uint64_t start = 0;
+
+    if (it->count > NANORESOURCE_TRACE_EVENTS) {
+      start = it->count - NANORESOURCE_TRACE_EVENTS;
+    }
+
+    for (uint64_t i = start; i < it->count; ++i) {
+      const struct nanoresource_trace_event_s *entry =
+        &it->events[i % NANORESOURCE_TRACE_EVENTS];
+
+      const char *name = nanoresource_trace_type_name(entry->type);
+
+      switch (entry->event) {
+        case NANORESOURCE_TRACE_ENQUEUE:
+          nanoresource_trace_write_event(
+            stream, it->thread, entry, "b", "queued", &first);
+          break;
+
+        case NANORESOURCE_TRACE_RUN:
+          nanoresource_trace_write_event(
+            stream, it->thread, entry, "e", "queued", &first);
+          nanoresource_trace_write_event(
+            stream, it->thread, entry, "b", name, &first);
+          break;
+
+        case NANORESOURCE_TRACE_COMPLETE:
+          nanoresource_trace_write_event(
+            stream, it->thread, entry, "e", name, &first);
+          break;
+
+        case NANORESOURCE_TRACE_FREE:
+          nanoresource_trace_write_event(
+            stream, it->thread, entry, "n", "free", &first);
+          break;
+
+        default:
+          continue;
+      }
+
+      (void) written++;
+    }
+  }
+
+  fprintf(stream, "\n]}\n");
+  return written;
+}
+
+int
+nanoresource_trace_reset() {
+  struct nanoresource_trace_ring_s *it = nanoresource_trace_rings;
+
+  for (; 0 != it; it = it->next) {
+    it->count = 0;
+  }
+
+  return 0;
+}
+
+int
+nanoresource_trace_release() {
+  if (0 != nanoresource_trace_self) {
+#if defined(__GNUC__)
+    __sync_lock_release(&nanoresource_trace_self->owned);
+#else
+    nanoresource_trace_self->owned = 0;
+#endif
+    nanoresource_trace_self = 0;
+  }
+
+  return 0;
+}
+
+#else
+
+int
+nanoresource_trace_dump(FILE *stream) {
+  require(stream, EFAULT);
+  errno = ENOSYS;
+  return -errno;
+}
+
+int
+nanoresource_trace_reset() {
+  errno = ENOSYS;
+  return -errno;
+}
+
+int
+nanoresource_trace_release() {
+  errno = ENOSYS;
+  return -errno;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#include "nanoresource.h"
+#include <nanoresource/nanoresource.hpp>
+#include <cstdio>
+#include <ok/ok.h>
+
+#ifndef OK_EXPECTED
+#define OK_EXPECTED 0
+#endif
+
+static void
+test_inlined(void) {
+  int closed = -1;
+
+  // the queue and state machine are inlined from the amalgamation
+  auto resource = nanoresource::make_resource();
+
+  resource.open();
+  resource.run([](nanoresource::request r) { r.done(); });
+  resource.close([&](int err) { closed = err; });
+
+  if (0 == closed && 1 == resource.get()->closed) {
+    ok("the amalgamation compiles and runs in a C++ translation unit");
+  }
+}
+
+int
+main(void) {
+  printf("### ok: expecting %d\n", OK_EXPECTED);
+  ok_expect(OK_EXPECTED);
+
+  test_inlined();
+
+  ok_done();
+  return ok_expected() - ok_count();
+}
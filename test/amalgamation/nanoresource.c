@@ -0,0 +1,2 @@
+#define NANORESOURCE_IMPLEMENTATION
+#include "nanoresource.h"
@@ -0,0 +1,85 @@
+#include <nanoresource/coroutine.hpp>
+#include <cstdio>
+#include <ok/ok.h>
+
+#ifndef OK_EXPECTED
+#define OK_EXPECTED 0
+#endif
+
+static nanoresource_request_s *parked = nullptr;
+static int results[3] = { -1, -1, -1 };
+static int finished = 0;
+
+// parks a lifecycle request until it is completed by the test
+static void
+park(nanoresource::request r) {
+  parked = r.get();
+}
+
+static void
+resume_parked(unsigned int err) {
+  nanoresource_request_s *request = parked;
+  parked = nullptr;
+  request->callback(request, err);
+}
+
+static nanoresource::task
+job(nanoresource::async resource) {
+  results[0] = co_await resource.open();
+  results[1] = co_await resource.run([](nanoresource::request r) {
+    r.done(EIO);
+  });
+
+  // the frame is destroyed from `after()` of the request stored in it
+  results[2] = co_await resource.close();
+  finished = 1;
+}
+
+static void
+test_await(void) {
+  auto resource = nanoresource::make_resource(park, park);
+
+  job(resource);
+
+  if (nullptr != parked && -1 == results[0]) {
+    ok("co_await suspends until the request completes");
+  }
+
+  resume_parked(0);
+  resume_parked(0);
+
+  if (1 == finished && 0 == results[0] && EIO == results[1] && 0 == results[2]) {
+    ok("co_await evaluates to the error code of the request");
+  }
+}
+
+static void
+test_null(void) {
+  int err = -1;
+
+  [&]() -> nanoresource::task {
+    err = co_await nanoresource::async(nullptr).open();
+  }();
+
+  if (EFAULT == err) {
+    ok("co_await on a null resource evaluates to EFAULT");
+  }
+}
+
+int
+main(void) {
+  printf("### ok: expecting %d\n", OK_EXPECTED);
+  ok_expect(OK_EXPECTED);
+
+  test_await();
+  test_null();
+
+  const nanoresource_allocator_stats_s stats = nanoresource_allocator_stats();
+
+  if (stats.alloc == stats.free) {
+    ok("stats.alloc == stats.free");
+  }
+
+  ok_done();
+  return ok_expected() - ok_count();
+}
@@ -0,0 +1,122 @@
+#include <nanoresource/nanoresource.hpp>
+#include <cstdio>
+#include <ok/ok.h>
+
+#ifndef OK_EXPECTED
+#define OK_EXPECTED 0
+#endif
+
+static nanoresource_request_s *parked = nullptr;
+static int destroyed = 0;
+
+struct parking {
+  // the first open is parked until it is completed by the test
+  void
+  open(nanoresource::request r) {
+    if (nullptr == parked) {
+      parked = r.get();
+    } else {
+      r.done();
+    }
+  }
+
+  ~parking() {
+    destroyed++;
+  }
+};
+
+static void
+test_lambdas(void) {
+  int opened = 0;
+  int ran = 0;
+  int closed = 0;
+  int done = -1;
+
+  auto resource = nanoresource::make_resource(
+    [&](nanoresource::request r) { opened++; r.done(); },
+    [&](nanoresource::request r) { closed++; r.done(); });
+
+  resource.open();
+  resource.run(
+    [&](nanoresource::request r) { ran++; r.done(); },
+    [&](int err) { done = err; });
+  resource.close();
+
+  if (1 == opened && 1 == ran && 0 == done && 1 == closed) {
+    ok("nanoresource::resource runs open, user work, and close");
+  }
+}
+
+static void
+test_reset(void) {
+  nanoresource_options_s options = {};
+  options.highwater = 2;
+
+  {
+    nanoresource::resource<parking> resource(options);
+
+    resource.open();
+    resource.open();
+
+    // the close implied by destroy is over the high watermark
+    int err = resource.reset();
+
+    if (-EAGAIN == err && resource && 0 == destroyed) {
+      ok("nanoresource::resource::reset() keeps ownership when it fails");
+    }
+
+    parked->callback(parked, 0);
+  }
+
+  if (1 == destroyed) {
+    ok("nanoresource::resource destroys Impl once");
+  }
+}
+
+static void
+test_scope(void) {
+  nanoresource_options_s options = {};
+  options.highwater = 2;
+  parked = nullptr;
+  destroyed = 0;
+
+  {
+    nanoresource::resource<parking> resource(options);
+
+    resource.open();
+    resource.open();
+  }
+
+  // the destroy of a resource going out of scope waits behind the queue
+  int waited = 0 == destroyed;
+  parked->callback(parked, 0);
+
+  if (1 == waited && 1 == destroyed) {
+    ok("nanoresource::resource is destroyed when requests are queued");
+  }
+}
+
+int
+main(void) {
+  printf("### ok: expecting %d\n", OK_EXPECTED);
+  ok_expect(OK_EXPECTED);
+
+  test_lambdas();
+  test_reset();
+  test_scope();
+
+  const nanoresource_allocator_stats_s stats = nanoresource_allocator_stats();
+  const nanoresource_pool_stats_s pools = nanoresource_pool_stats();
+
+  if (stats.alloc == stats.free) {
+    ok("stats.alloc == stats.free");
+  }
+
+  // memory allocated by the bindings is not counted as pool usage
+  if (0 == pools.resources && 0 == pools.requests) {
+    ok("nanoresource_pool_stats() counts only the pools");
+  }
+
+  ok_done();
+  return ok_expected() - ok_count();
+}
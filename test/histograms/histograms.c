@@ -0,0 +1,97 @@
+#include <nanoresource/nanoresource.h>
+#include <stdio.h>
+#include <errno.h>
+#include <ok/ok.h>
+
+#ifndef OK_EXPECTED
+#define OK_EXPECTED 0
+#endif
+
+static struct nanoresource_request_s *parked = 0;
+
+static void
+work(struct nanoresource_request_s *request) {
+  request->callback(request, 0);
+}
+
+static void
+park(struct nanoresource_request_s *request) {
+  parked = request;
+}
+
+static void
+test_record(void) {
+  struct nanoresource_histogram_s running = { 0 };
+  struct nanoresource_histogram_s queued = { 0 };
+  struct nanoresource_histogram_s opened = { 0 };
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { .open = park });
+
+  // user requests wait in the queue behind the parked open
+  nanoresource_open(resource, 0);
+
+  for (int i = 0; i < 10; ++i) {
+    nanoresource_submit(resource,
+      nanoresource_request_new((struct nanoresource_request_options_s) {
+        .type = NANORESOURCE_REQUEST_USER,
+        .resource = resource,
+        .user = work,
+      }));
+  }
+
+  // spends a millisecond in the queue and in the open
+  uint64_t until = nanoresource_clock_now() + 1000000;
+  while (nanoresource_clock_now() < until) { }
+
+  parked->callback(parked, 0);
+
+  nanoresource_histogram_snapshot(resource,
+    NANORESOURCE_REQUEST_OPEN, NANORESOURCE_HISTOGRAM_RUNNING, &opened);
+  nanoresource_histogram_snapshot(resource,
+    NANORESOURCE_REQUEST_USER, NANORESOURCE_HISTOGRAM_RUNNING, &running);
+  nanoresource_histogram_snapshot(resource,
+    NANORESOURCE_REQUEST_USER, NANORESOURCE_HISTOGRAM_QUEUED, &queued);
+
+  if (1 == opened.count && opened.max >= 1000000) {
+    ok("the open of a resource is recorded in its histograms");
+  }
+
+  if (10 == running.count && 10 == queued.count && queued.min >= 1000000) {
+    ok("user requests are recorded per phase in their resource histograms");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static void
+test_snapshot(void) {
+  struct nanoresource_histogram_s snapshot = { 0 };
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { 0 });
+
+  int err = nanoresource_histogram_snapshot(resource,
+    NANORESOURCE_REQUEST_USER, NANORESOURCE_HISTOGRAM_PHASES, &snapshot);
+
+  if (
+    -EINVAL == err &&
+    0 == nanoresource_histogram_snapshot(resource,
+      NANORESOURCE_REQUEST_USER, NANORESOURCE_HISTOGRAM_RUNNING, &snapshot) &&
+    0 == snapshot.count
+  ) {
+    ok("nanoresource_histogram_snapshot() copies a resource histogram");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+int
+main(void) {
+  printf("### ok: expecting %d\n", OK_EXPECTED);
+  ok_expect(OK_EXPECTED);
+
+  test_record();
+  test_snapshot();
+
+  ok_done();
+  return ok_expected() - ok_count();
+}
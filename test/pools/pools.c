@@ -0,0 +1,156 @@
+#include <nanoresource/nanoresource.h>
+#include <stdio.h>
+#include <errno.h>
+#include <ok/ok.h>
+
+#ifndef OK_EXPECTED
+#define OK_EXPECTED 0
+#endif
+
+static struct nanoresource_request_s *parked = 0;
+
+static void
+park(struct nanoresource_request_s *request) {
+  parked = request;
+}
+
+static void
+test_resources(void) {
+  struct nanoresource_s *resources[NANORESOURCE_MAX_RESOURCES] = { 0 };
+
+  for (int i = 0; i < NANORESOURCE_MAX_RESOURCES; ++i) {
+    resources[i] = nanoresource_new((struct nanoresource_options_s) { 0 });
+  }
+
+  struct nanoresource_s *exhausted = nanoresource_new(
+    (struct nanoresource_options_s) { 0 });
+
+  if (0 == exhausted && ENOMEM == errno) {
+    ok("nanoresource_new() -> ENOMEM when the resource pool is exhausted");
+  }
+
+  nanoresource_destroy(resources[0], 0);
+  resources[0] = nanoresource_new((struct nanoresource_options_s) { 0 });
+
+  if (0 != resources[0]) {
+    ok("destroyed resources go back to the pool");
+  }
+
+  for (int i = 0; i < NANORESOURCE_MAX_RESOURCES; ++i) {
+    nanoresource_destroy(resources[i], 0);
+  }
+}
+
+static void
+test_requests(void) {
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { .open = park });
+
+  // the parked open holds a request until it completes
+  for (int i = 0; i < NANORESOURCE_MAX_REQUESTS; ++i) {
+    nanoresource_open(resource, 0);
+  }
+
+  if (-EAGAIN == nanoresource_open(resource, 0)) {
+    ok("nanoresource_open() -> EAGAIN when the request pool is exhausted");
+  }
+
+  parked->callback(parked, 0);
+
+  if (0 == nanoresource_destroy(resource, 0)) {
+    ok("completed requests go back to the pool");
+  }
+}
+
+static int generations[2] = { 0 };
+static void *closed_generation = 0;
+
+static void
+next_generation(struct nanoresource_request_s *request) {
+  if (0 != request->data) {
+    request->data = (int *) request->data + 1;
+  }
+
+  request->callback(request, 0);
+}
+
+static void
+close_generation(struct nanoresource_request_s *request) {
+  if (0 != request->data) {
+    closed_generation = request->data;
+  }
+
+  request->callback(request, 0);
+}
+
+static void
+test_retire(void) {
+  void *pinned = 0;
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) {
+      .open = next_generation,
+      .close = close_generation,
+      .data = &generations[0],
+    });
+
+  struct nanoresource_s *busy = nanoresource_new(
+    (struct nanoresource_options_s) { .open = park });
+
+  nanoresource_open(resource, 0);
+  nanoresource_acquire(resource, &pinned);
+  nanoresource_reopen(resource, 0);
+
+  // the requests parked on `busy` leave none to close the generation with
+  parked = 0;
+  while (0 == nanoresource_open(busy, 0)) { }
+
+  nanoresource_release(resource, pinned);
+  int kept = 0 == closed_generation;
+
+  parked->callback(parked, 0);
+  nanoresource_destroy(resource, 0);
+
+  if (1 == kept && &generations[0] == closed_generation) {
+    ok("a replaced generation is closed once a request can be allocated");
+  }
+
+  nanoresource_destroy(busy, 0);
+}
+
+static void
+test_unpooled(void) {
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { 0 });
+
+  if (-ENOSYS == nanoresource_pipeline(resource, 0, 0, 0, 0)) {
+    ok("nanoresource_pipeline() -> ENOSYS with static pools");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+int
+main(void) {
+  printf("### ok: expecting %d\n", OK_EXPECTED);
+  ok_expect(OK_EXPECTED);
+
+  test_resources();
+  test_requests();
+  test_retire();
+  test_unpooled();
+
+  // retired slots go back once no reader can observe them with epochs
+  nanoresource_epoch_synchronize();
+
+  const struct nanoresource_allocator_stats_s stats =
+    nanoresource_allocator_stats();
+  const struct nanoresource_pool_stats_s pools = nanoresource_pool_stats();
+
+  // retiring resources and requests with epochs allocates nothing either
+  if (0 == stats.alloc && 0 == pools.resources && 0 == pools.requests) {
+    ok("static pools allocate nothing and free every slot");
+  }
+
+  ok_done();
+  return ok_expected() - ok_count();
+}
@@ -1,5 +1,8 @@
 #include <nanoresource/nanoresource.h>
+#include <nanoresource/specialize.h>
 #include <stdio.h>
+#include <errno.h>
+#include <string.h>
 #include <ok/ok.h>
 
 #ifndef OK_EXPECTED
@@ -39,6 +42,723 @@ ondestroy(struct nanoresource_s *resource, int err) {
   ok("ondestroy()");
 }
 
+static struct nanoresource_request_s *parked = 0;
+
+static void
+park(struct nanoresource_request_s *request) {
+  parked = request;
+}
+
+static void
+ondrain(struct nanoresource_s *resource) {
+  // the queue has settled, so requests pushed from the callback run now
+  if (
+    0 == resource->pending &&
+    0 == resource->throttled &&
+    0 == nanoresource_open(resource, 0)
+  ) {
+    ok("ondrain()");
+  }
+}
+
+static void
+test_backpressure(void) {
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) {
+      .open = park,
+      .drain = ondrain,
+      .highwater = 2,
+    });
+
+  nanoresource_open(resource, 0);
+  nanoresource_open(resource, 0);
+
+  if (-EAGAIN == nanoresource_open(resource, 0)) {
+    ok("nanoresource_open() -> EAGAIN");
+  }
+
+  parked->callback(parked, 0);
+  nanoresource_destroy(resource, 0);
+}
+
+static void
+ondestroyqueued(struct nanoresource_s *resource, int err) {
+  ok("ondestroyqueued()");
+}
+
+static void
+test_destroy_queued(void) {
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { .open = park });
+
+  // the close and destroy drained behind the open free the resource from
+  // its dequeue, which must not touch it afterwards
+  nanoresource_open(resource, 0);
+  nanoresource_destroy(resource, ondestroyqueued);
+  parked->callback(parked, 0);
+}
+
+static int failures = 2;
+
+static void
+flaky(struct nanoresource_request_s *request) {
+  request->callback(request, failures-- > 0 ? EMFILE : 0);
+}
+
+static void
+onretry(struct nanoresource_s *resource, int err) {
+  if (0 == err && -1 == failures) {
+    ok("onretry()");
+  }
+}
+
+static void
+test_retry(void) {
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) {
+      .open = flaky,
+      .retry = { .attempts = 3, .delay = 0, .jitter = 50 },
+    });
+
+  nanoresource_open(resource, onretry);
+
+  while (nanoresource_timers_timeout() >= 0) {
+    nanoresource_timers_run();
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static void
+onevent(
+  struct nanoresource_observer_s *observer,
+  const struct nanoresource_event_s *event
+) {
+  uint64_t *timestamp = observer->data;
+
+  if (0 == event->err && event->timestamp >= *timestamp) {
+    switch (event->type) {
+      case NANORESOURCE_REQUEST_OPEN: ok("onevent(open)"); break;
+      case NANORESOURCE_REQUEST_CLOSE: ok("onevent(close)"); break;
+      case NANORESOURCE_REQUEST_DESTROY: ok("onevent(destroy)"); break;
+      default: break;
+    }
+  }
+
+  *timestamp = event->timestamp;
+}
+
+static void
+test_observer(void) {
+  uint64_t timestamp = 0;
+  struct nanoresource_observer_s observer = { 0 };
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { 0 });
+
+  nanoresource_observer_init(&observer, onevent, &timestamp);
+  nanoresource_resource_observe(resource, &observer);
+
+  // the tail of a list has no next observer but is still attached
+  if (-EEXIST == nanoresource_observe(&observer)) {
+    ok("nanoresource_observe() rejects an observer attached elsewhere");
+  }
+
+  nanoresource_open(resource, 0);
+  nanoresource_close(resource, 0);
+  nanoresource_destroy(resource, 0);
+
+  // freeing the resource detached it
+  if (0 == nanoresource_observe(&observer)) {
+    ok("nanoresource_observe() attaches an observer of a freed resource");
+  }
+
+  nanoresource_unobserve(&observer);
+}
+
+static void
+test_handles(void) {
+  struct nanoresource_handles_s handles = { 0 };
+  nanoresource_handles_init(&handles, 1);
+
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { 0 });
+
+  nanoresource_handle_t handle = nanoresource_handle_insert(&handles, resource);
+  int found = resource == nanoresource_handle_get(&handles, handle);
+
+  nanoresource_destroy(resource, 0);
+
+  if (found && 0 == nanoresource_handle_get(&handles, handle) && ESTALE == errno) {
+    ok("nanoresource_handle_get() rejects stale handles");
+  }
+
+  resource = nanoresource_new((struct nanoresource_options_s) { 0 });
+  nanoresource_handle_t reused = nanoresource_handle_insert(&handles, resource);
+
+  if (reused != handle && 0 == nanoresource_handle_get(&handles, handle)) {
+    ok("nanoresource_handle_insert() reuses slots with a new generation");
+  }
+
+  nanoresource_destroy(resource, 0);
+  nanoresource_handles_destroy(&handles);
+}
+
+static unsigned int exclusive_actives = 1;
+
+static void
+exclusive(struct nanoresource_request_s *request) {
+  exclusive_actives = request->resource->actives;
+  request->callback(request, 0);
+}
+
+static void
+test_exclusive(void) {
+  struct nanoresource_request_s request = { 0 };
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { 0 });
+
+  nanoresource_open(resource, 0);
+  nanoresource_active_shared(resource);
+  nanoresource_active_exclusive(resource, exclusive, 0);
+
+  int refused = EBUSY == nanoresource_active_shared(resource);
+  int waited = 1 == exclusive_actives;
+
+  nanoresource_inactive(resource);
+
+  // requests queued after the exclusive request are not held back
+  nanoresource_request_init(&request, (struct nanoresource_request_options_s) {
+    .type = NANORESOURCE_REQUEST_USER,
+    .resource = resource,
+  });
+
+  nanoresource_submit(resource, &request);
+
+  if (refused && waited && 0 == exclusive_actives && 0 == resource->queued) {
+    ok("nanoresource_active_exclusive()");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static struct nanoresource_request_s *inflight[3] = { 0 };
+static unsigned int started = 0;
+
+static void
+start(struct nanoresource_request_s *request) {
+  inflight[started++] = request;
+}
+
+static void
+test_max_inflight(void) {
+  struct nanoresource_request_s requests[3] = { 0 };
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { .max_inflight = 2 });
+
+  nanoresource_open(resource, 0);
+
+  for (int i = 0; i < 3; ++i) {
+    nanoresource_request_init(&requests[i], (struct nanoresource_request_options_s) {
+      .type = NANORESOURCE_REQUEST_USER,
+      .resource = resource,
+      .user = start,
+    });
+
+    nanoresource_submit(resource, &requests[i]);
+  }
+
+  unsigned int bounded = 2 == started;
+
+  // completing out of order frees a slot for the queued request
+  inflight[1]->callback(inflight[1], 0);
+  inflight[0]->callback(inflight[0], 0);
+  inflight[2]->callback(inflight[2], 0);
+
+  if (1 == bounded && 3 == started && 0 == resource->queued) {
+    ok("max_inflight runs user requests concurrently");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static void
+test_discipline(void) {
+  struct nanoresource_request_s requests[3] = { 0 };
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) {
+      .discipline = NANORESOURCE_QUEUE_PRIORITY
+    });
+
+  for (int i = 0; i < 3; ++i) {
+    nanoresource_request_init(&requests[i], (struct nanoresource_request_options_s) {
+      .type = NANORESOURCE_REQUEST_USER,
+      .resource = resource,
+      .user = park,
+      .priority = i,
+    });
+
+    nanoresource_submit(resource, &requests[i]);
+  }
+
+  // the running request stays at the head
+  if (&requests[0] == parked && &requests[2] == resource->queue[1]) {
+    ok("NANORESOURCE_QUEUE_PRIORITY runs higher priority requests first");
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    parked->callback(parked, 0);
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static char schedule[16] = { 0 };
+static unsigned int scheduled = 0;
+
+static void
+record(struct nanoresource_request_s *request) {
+  schedule[scheduled++] = *(char *) request->resource->data;
+  request->callback(request, 0);
+}
+
+static void
+test_scheduler(void) {
+  struct nanoresource_s *resources[2] = {
+    nanoresource_new((struct nanoresource_options_s) { .weight = 2, .data = "a" }),
+    nanoresource_new((struct nanoresource_options_s) { .weight = 1, .data = "b" }),
+  };
+
+  for (int i = 0; i < 9; ++i) {
+    struct nanoresource_s *resource = resources[i < 6 ? 0 : 1];
+    nanoresource_submit(resource, nanoresource_request_new(
+      (struct nanoresource_request_options_s) {
+        .type = NANORESOURCE_REQUEST_USER,
+        .resource = resource,
+        .user = record,
+      }));
+  }
+
+  int started = nanoresource_scheduler_run(0);
+
+  if (9 == started && 0 == strcmp("aabaabaab", schedule)) {
+    ok("nanoresource_scheduler_run() shares turns by weight");
+  }
+
+  nanoresource_destroy(resources[0], 0);
+  nanoresource_destroy(resources[1], 0);
+  nanoresource_scheduler_run(0);
+}
+
+static int generations[2] = { 0 };
+static void *closed_generation = 0;
+
+static void
+next_generation(struct nanoresource_request_s *request) {
+  if (0 != request->data) {
+    request->data = (int *) request->data + 1;
+  }
+
+  request->callback(request, 0);
+}
+
+static void
+close_generation(struct nanoresource_request_s *request) {
+  closed_generation = request->data;
+  request->callback(request, 0);
+}
+
+static void
+test_reopen(void) {
+  void *pinned = 0;
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) {
+      .open = next_generation,
+      .close = close_generation,
+      .data = &generations[0],
+    });
+
+  nanoresource_open(resource, 0);
+  nanoresource_acquire(resource, &pinned);
+  nanoresource_reopen(resource, 0);
+
+  // the pinned generation stays open until it is released
+  int kept = &generations[1] == resource->data && 0 == closed_generation;
+  nanoresource_release(resource, pinned);
+
+  if (1 == kept && &generations[0] == closed_generation) {
+    ok("nanoresource_reopen() closes the previous generation once released");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static struct nanoresource_file_slice_s slices[3] = { 0 };
+static int read_errors[3] = { 0 };
+static unsigned int reads = 0;
+
+static void
+onread(
+  struct nanoresource_file_s *file,
+  int err,
+  const struct nanoresource_file_slice_s *slice
+) {
+  read_errors[reads] = err;
+  slices[reads++] = *slice;
+}
+
+static void
+test_file(void) {
+  const char *filename = "file.test.tmp";
+  struct nanoresource_file_s file;
+  FILE *stream = fopen(filename, "w");
+
+  fputs("hello", stream);
+  fflush(stream);
+
+  nanoresource_file_init(&file, (struct nanoresource_file_options_s) {
+    .filename = filename,
+    .advice = NANORESOURCE_FILE_SEQUENTIAL,
+  });
+
+  nanoresource_open(&file.resource, 0);
+  nanoresource_file_read(&file, 0, 5, onread);
+
+  // reading past the mapping maps the file again, the first slice stays
+  fputs(" world", stream);
+  fflush(stream);
+  nanoresource_file_read(&file, 6, 5, onread);
+
+  // the first mapping is still pinned so the file cannot be mapped again
+  fputs("!", stream);
+  fclose(stream);
+  nanoresource_file_read(&file, 11, 1, onread);
+
+  if (
+    3 == reads &&
+    5 == slices[0].length &&
+    5 == slices[1].length &&
+    0 == memcmp("hello", slices[0].data, slices[0].length) &&
+    0 == memcmp("world", slices[1].data, slices[1].length) &&
+    slices[0].map != slices[1].map &&
+    EBUSY == read_errors[2]
+  ) {
+    ok("nanoresource_file_read() returns slices of the mapping");
+  }
+
+  nanoresource_file_release(&file, &slices[0]);
+  nanoresource_file_release(&file, &slices[1]);
+  nanoresource_destroy(&file.resource, 0);
+  remove(filename);
+}
+
+static unsigned int steps = 0;
+static int pipelined = -1;
+
+static void
+step(struct nanoresource_request_s *request) {
+  (void) (*(unsigned int *) request->data)++;
+  request->callback(request, 0);
+}
+
+static void
+onpipeline(struct nanoresource_s *resource, int err, void *data) {
+  pipelined = err;
+}
+
+static void
+test_pipeline(void) {
+  nanoresource_request_work_callback_t *work[3] = { step, step, step };
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { 0 });
+
+  nanoresource_pipeline(resource, work, 3, onpipeline, &steps);
+
+  if (3 == steps && 0 == pipelined && 1 == resource->closed) {
+    ok("nanoresource_pipeline() runs open, steps, and close as one unit");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static uint64_t completed = 0;
+
+static void
+payload_work(struct nanoresource_request_s *request) {
+  request->callback(request, 0);
+}
+
+static void
+oncomplete(struct nanoresource_request_s *request, int err) {
+  uint64_t *value = nanoresource_request_payload(request);
+  completed = 0 == err && 0 != value ? *value : 0;
+}
+
+static void
+test_payload(void) {
+  uint64_t value = 42;
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { 0 });
+
+  struct nanoresource_request_s *request = nanoresource_request_new(
+    (struct nanoresource_request_options_s) {
+      .type = NANORESOURCE_REQUEST_USER,
+      .resource = resource,
+      .user = payload_work,
+      .complete = oncomplete,
+      .payload = &value,
+      .payload_size = sizeof(value),
+    });
+
+  // payloads larger than `NANORESOURCE_REQUEST_PAYLOAD_SIZE` are rejected
+  int rejected =
+    0 == request &&
+    EINVAL == errno &&
+    NANORESOURCE_REQUEST_PAYLOAD_SIZE < sizeof(value);
+
+  value = 0;
+  nanoresource_open(resource, 0);
+
+  if (0 != request && nanoresource_queue_push(resource, request) > 0) {
+    if (1 == nanoresource_request_runnable(request)) {
+      nanoresource_request_run(request);
+    }
+  }
+
+  if (42 == completed || 1 == rejected) {
+    ok("nanoresource_request_s carries an inline payload to complete()");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static unsigned int sync_closed = 0;
+
+static void
+sync_work(struct nanoresource_request_s *request) {
+  // waits behind the running request instead of passing it
+  nanoresource_close(request->resource, 0);
+  sync_closed = request->resource->closed;
+  request->callback(request, EIO);
+}
+
+static void
+test_sync(void) {
+  struct nanoresource_request_s request;
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { .sync = 1 });
+
+  nanoresource_open(resource, 0);
+  nanoresource_request_init(&request, (struct nanoresource_request_options_s) {
+    .type = NANORESOURCE_REQUEST_USER,
+    .resource = resource,
+    .user = sync_work,
+  });
+
+  int err = nanoresource_submit(resource, &request);
+
+  if (-EIO == err && 0 == sync_closed && 1 == resource->closed) {
+    ok("nanoresource_submit() runs requests inline on idle sync resources");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static unsigned int specialized = 0;
+
+static void
+specialized_work(struct nanoresource_request_s *request) {
+  (void) specialized++;
+  request->callback(request, 0);
+}
+
+NANORESOURCE_SPECIALIZE(
+  counter,
+  specialized_work,
+  specialized_work,
+  0,
+  specialized_work)
+
+static void
+test_specialize(void) {
+  struct nanoresource_s resource;
+  struct nanoresource_request_s request;
+
+  counter_init(&resource, (struct nanoresource_options_s) { 0 });
+  counter_open(&resource, 0);
+  nanoresource_request_init(&request, (struct nanoresource_request_options_s) {
+    .type = NANORESOURCE_REQUEST_USER,
+    .resource = &resource,
+  });
+
+  counter_submit(&resource, &request);
+  counter_close(&resource, 0);
+
+  if (3 == specialized && 1 == resource.closed) {
+    ok("NANORESOURCE_SPECIALIZE() calls the operations directly");
+  }
+
+  nanoresource_destroy(&resource, 0);
+}
+
+static struct nanoresource_request_s *sync_parked = 0;
+
+static void
+sync_park(struct nanoresource_request_s *request) {
+  sync_parked = request;
+}
+
+static void
+test_specialize_sync(void) {
+  struct nanoresource_s resource;
+
+  specialized = 0;
+  counter_init(&resource, (struct nanoresource_options_s) { .sync = 1 });
+  counter_open(&resource, 0);
+
+  int err = counter_submit(&resource,
+    nanoresource_request_new((struct nanoresource_request_options_s) {
+      .type = NANORESOURCE_REQUEST_USER,
+      .resource = &resource,
+    }));
+
+  if (0 == err && 2 == specialized && 0 == resource.pending) {
+    ok("NANORESOURCE_SPECIALIZE() runs requests inline on sync resources");
+  }
+
+  // an operation completing later keeps its request until it completes
+  err = nanoresource_submit(&resource,
+    nanoresource_request_new((struct nanoresource_request_options_s) {
+      .type = NANORESOURCE_REQUEST_USER,
+      .resource = &resource,
+      .user = sync_park,
+    }));
+
+  int running = 1 == resource.queued && sync_parked == resource.queue[0];
+  sync_parked->callback(sync_parked, 0);
+
+  if (-EBUSY == err && 1 == running && 0 == resource.queued) {
+    ok("nanoresource_submit() -> EBUSY when a sync request completes later");
+  }
+
+  nanoresource_destroy(&resource, 0);
+}
+
+static unsigned int sync_destroyed = 0;
+
+static void
+onsyncdestroy(struct nanoresource_s *resource, int err) {
+  (void) sync_destroyed++;
+}
+
+static void
+sync_destroy(struct nanoresource_request_s *request) {
+  nanoresource_destroy(request->resource, onsyncdestroy);
+  request->callback(request, EIO);
+}
+
+static void
+sync_fill(struct nanoresource_request_s *request) {
+  sync_parked = request;
+
+  while (nanoresource_open(request->resource, 0) >= 0) { }
+}
+
+static void
+test_sync_queue(void) {
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { .sync = 1 });
+
+  nanoresource_open(resource, 0);
+
+  // the destroy queued by the operation frees the resource as it completes
+  int err = nanoresource_submit(resource,
+    nanoresource_request_new((struct nanoresource_request_options_s) {
+      .type = NANORESOURCE_REQUEST_USER,
+      .resource = resource,
+      .user = sync_destroy,
+    }));
+
+  if (-EIO == err && 1 == sync_destroyed) {
+    ok("nanoresource_submit() runs a sync request that destroys its resource");
+  }
+
+  resource = nanoresource_new((struct nanoresource_options_s) { .sync = 1 });
+  nanoresource_open(resource, 0);
+
+  // the request keeps its place at the head of a queue filled behind it
+  err = nanoresource_submit(resource,
+    nanoresource_request_new((struct nanoresource_request_options_s) {
+      .type = NANORESOURCE_REQUEST_USER,
+      .resource = resource,
+      .user = sync_fill,
+    }));
+
+  int full =
+    NANORESOURCE_MAX_REQUEST_QUEUE == resource->queued &&
+    sync_parked == resource->queue[0];
+
+  sync_parked->callback(sync_parked, 0);
+
+  if (-EBUSY == err && 1 == full && 0 == resource->queued) {
+    ok("nanoresource_submit() -> EBUSY when a sync request fills the queue");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static unsigned int reclaimed = 0;
+
+static void
+reclaim(void *pointer) {
+  (void) reclaimed++;
+}
+
+static void
+test_epoch(void) {
+  struct nanoresource_epoch_node_s nodes[2] = { 0 };
+  int value = 0;
+
+  nanoresource_epoch_enter();
+  nanoresource_epoch_retire(&nodes[0], &value, reclaim);
+  nanoresource_epoch_collect();
+  unsigned int deferred = 0 == reclaimed;
+  nanoresource_epoch_leave();
+
+  // also releases resources and requests retired by the library
+  nanoresource_epoch_synchronize();
+
+  if (1 == deferred && 1 == reclaimed) {
+    ok("nanoresource_epoch_retire() defers until readers leave");
+  }
+
+  nanoresource_epoch_enter();
+  nanoresource_epoch_retire(&nodes[1], &value, reclaim);
+  int busy = -EBUSY == nanoresource_epoch_release();
+  nanoresource_epoch_leave();
+
+  if (1 == busy && nanoresource_epoch_release() >= 1 && 2 == reclaimed) {
+    ok("nanoresource_epoch_release() releases the retired pointers");
+  }
+}
+
+static void
+test_histogram(void) {
+  struct nanoresource_histogram_s histogram = { 0 };
+  struct nanoresource_histogram_s merged = { 0 };
+
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    nanoresource_histogram_record(&histogram, i * 1000);
+  }
+
+  nanoresource_histogram_merge(&merged, &histogram);
+  nanoresource_histogram_merge(&merged, &histogram);
+
+  uint64_t p50 = nanoresource_histogram_percentile(&merged, 50);
+  if (2000 == merged.count && p50 >= 500000 && p50 <= 500000 + 500000 / 8) {
+    ok("nanoresource_histogram_percentile()");
+  }
+}
+
 int
 main(void) {
   printf("### ok: expecting %d\n", OK_EXPECTED);
@@ -75,12 +795,37 @@ main(void) {
     ok("nanoresource_inactive()");
   }
 
+  test_backpressure();
+  test_destroy_queued();
+  test_retry();
+  test_observer();
+  test_histogram();
+  test_handles();
+  test_exclusive();
+  test_max_inflight();
+  test_discipline();
+  test_scheduler();
+  test_reopen();
+  test_file();
+  test_pipeline();
+  test_payload();
+  test_sync();
+  test_specialize();
+  test_specialize_sync();
+  test_sync_queue();
+  test_epoch();
+
   const struct nanoresource_allocator_stats_s stats = nanoresource_allocator_stats();
   //printf("alloc=%d free=%d\n", stats.alloc, stats.free);
   if (stats.alloc == stats.free) {
     ok("stats.alloc == stats.free");
   }
 
+  const struct nanoresource_pool_stats_s pools = nanoresource_pool_stats();
+  if (0 == pools.resources && 0 == pools.requests) {
+    ok("nanoresource_pool_stats() counts every resource and request freed");
+  }
+
   printf("%s\n", nanoresource_version_string());
   ok_done();
   return ok_expected() - ok_count();
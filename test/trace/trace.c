@@ -0,0 +1,117 @@
+#include <nanoresource/nanoresource.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <ok/ok.h>
+
+#ifndef OK_EXPECTED
+#define OK_EXPECTED 0
+#endif
+
+static char dump[1 << 16] = { 0 };
+
+// dumps the trace into `dump`, returning the number of events written
+static int
+dump_trace(void) {
+  FILE *stream = tmpfile();
+  int written = nanoresource_trace_dump(stream);
+  size_t size = 0;
+
+  rewind(stream);
+  size = fread(dump, 1, sizeof(dump) - 1, stream);
+  dump[size] = 0;
+  fclose(stream);
+  return written;
+}
+
+static void
+work(struct nanoresource_request_s *request) {
+  request->callback(request, 0);
+}
+
+static void *
+record(void *data) {
+  struct nanoresource_s *resource = data;
+
+  nanoresource_submit(resource,
+    nanoresource_request_new((struct nanoresource_request_options_s) {
+      .type = NANORESOURCE_REQUEST_USER,
+      .resource = resource,
+      .user = work,
+    }));
+
+  nanoresource_trace_release();
+  return 0;
+}
+
+static void
+test_record(void) {
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { 0 });
+
+  nanoresource_trace_reset();
+  nanoresource_open(resource, 0);
+  record(resource);
+
+  // open and user requests are enqueued, run, completed, and freed
+  int written = dump_trace();
+
+  if (
+    8 == written &&
+    0 != strstr(dump, "\"traceEvents\":[") &&
+    0 != strstr(dump, "\"name\":\"queued\",\"cat\":\"open\",\"ph\":\"b\"") &&
+    0 != strstr(dump, "\"name\":\"user\",\"cat\":\"user\",\"ph\":\"e\"")
+  ) {
+    ok("nanoresource_trace_dump() writes the recorded request lifecycle");
+  }
+
+  nanoresource_trace_reset();
+
+  if (0 == dump_trace()) {
+    ok("nanoresource_trace_reset() discards the recorded events");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+static void
+test_release(void) {
+  struct nanoresource_s *resource = nanoresource_new(
+    (struct nanoresource_options_s) { 0 });
+  pthread_t thread;
+
+  nanoresource_open(resource, 0);
+  nanoresource_trace_reset();
+
+  // the second thread records into the ring released by the first
+  for (int i = 0; i < 2; ++i) {
+    pthread_create(&thread, 0, record, resource);
+    pthread_join(thread, 0);
+  }
+
+  int written = dump_trace();
+
+  // the main thread reclaimed its own ring as thread 2, the first thread
+  // recorded as thread 3 and its events are dropped with its ring
+  if (
+    4 == written &&
+    0 == strstr(dump, "\"tid\":3") &&
+    0 != strstr(dump, "\"tid\":4")
+  ) {
+    ok("nanoresource_trace_release() gives the ring to the next thread");
+  }
+
+  nanoresource_destroy(resource, 0);
+}
+
+int
+main(void) {
+  printf("### ok: expecting %d\n", OK_EXPECTED);
+  ok_expect(OK_EXPECTED);
+
+  test_record();
+  test_release();
+
+  ok_done();
+  return ok_expected() - ok_count();
+}